@@ -0,0 +1,113 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+Host implementation of the parts of the Arduino core stood in for by Arduino.h
+******************************************************************************/
+#include <Arduino.h>
+#include <stdarg.h>
+#include <chrono>
+
+HardwareSerial Serial;
+
+// Time skipped over by delay()
+static uint64_t _delayed_uS = 0;
+
+static uint64_t ElapseduS()
+{
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() + _delayed_uS;
+}
+
+unsigned long millis()
+{
+  return (unsigned long)(ElapseduS() / 1000);
+}
+
+unsigned long micros()
+{
+  return (unsigned long)ElapseduS();
+}
+
+void delay(unsigned long ms)
+{
+  _delayed_uS += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  _delayed_uS += us;
+}
+
+long random(long max)
+{
+  return max > 0 ? ::random() % max : 0;
+}
+
+long random(long min, long max)
+{
+  return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed)
+{
+  if(seed)
+    srandom(seed);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+  while(size--)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long n, int base)
+{
+  if(base == DEC)
+    return printf("%ld", n);
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+  return printf(base == HEX ? "%lX" : "%lu", n);
+}
+
+size_t Print::print(double n, int digits)
+{
+  return printf("%.*f", digits, n);
+}
+
+size_t Print::printf(const char *format, ...)
+{
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if(length < 0)
+    return 0;
+  return write((const uint8_t *)buffer, (size_t)length < sizeof(buffer) ? length : sizeof(buffer) - 1);
+}
@@ -0,0 +1,266 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+Host implementation of the stand-in Arduino_GFX base class
+******************************************************************************/
+#include <Arduino_GFX.h>
+
+// Classic 5x7 font for ' ' to '~', a byte per column with the top row in bit 0
+static const uint8_t font5x7[][5] PROGMEM = {
+  {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+  {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x56,0x20,0x50}, {0x00,0x08,0x07,0x03,0x00},
+  {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x2A,0x1C,0x7F,0x1C,0x2A}, {0x08,0x08,0x3E,0x08,0x08},
+  {0x00,0x80,0x70,0x30,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x00,0x60,0x60,0x00}, {0x20,0x10,0x08,0x04,0x02},
+  {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x72,0x49,0x49,0x49,0x46}, {0x21,0x41,0x49,0x4D,0x33},
+  {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x31}, {0x41,0x21,0x11,0x09,0x07},
+  {0x36,0x49,0x49,0x49,0x36}, {0x46,0x49,0x49,0x29,0x1E}, {0x00,0x00,0x14,0x00,0x00}, {0x00,0x40,0x34,0x00,0x00},
+  {0x00,0x08,0x14,0x22,0x41}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x59,0x09,0x06},
+  {0x3E,0x41,0x5D,0x59,0x4E}, {0x7C,0x12,0x11,0x12,0x7C}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+  {0x7F,0x41,0x41,0x41,0x3E}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x41,0x51,0x73},
+  {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+  {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x1C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+  {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x26,0x49,0x49,0x49,0x32},
+  {0x03,0x01,0x7F,0x01,0x03}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F},
+  {0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03}, {0x61,0x59,0x49,0x4D,0x43}, {0x00,0x7F,0x41,0x41,0x41},
+  {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x41,0x7F}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+  {0x00,0x03,0x07,0x08,0x00}, {0x20,0x54,0x54,0x78,0x40}, {0x7F,0x28,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x28},
+  {0x38,0x44,0x44,0x28,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x00,0x08,0x7E,0x09,0x02}, {0x18,0xA4,0xA4,0x9C,0x78},
+  {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x40,0x3D,0x00}, {0x7F,0x10,0x28,0x44,0x00},
+  {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x78,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+  {0xFC,0x18,0x24,0x24,0x18}, {0x18,0x24,0x24,0x18,0xFC}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x24},
+  {0x04,0x04,0x3F,0x44,0x24}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C},
+  {0x44,0x28,0x10,0x28,0x44}, {0x4C,0x90,0x90,0x90,0x7C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00},
+  {0x00,0x00,0x77,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x02,0x01,0x02,0x04,0x02}
+};
+
+void Arduino_GFX::writePixel(int16_t x, int16_t y, uint16_t color)
+{
+  if(x >= 0 && x < _width && y >= 0 && y < _height)
+    writePixelPreclipped(x, y, color);
+}
+
+void Arduino_GFX::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+  for(int16_t i = 0; i < h; i++)
+    writePixel(x, y + i, color);
+}
+
+void Arduino_GFX::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+  for(int16_t i = 0; i < w; i++)
+    writePixel(x + i, y, color);
+}
+
+void Arduino_GFX::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  for(int16_t j = 0; j < h; j++)
+    writeFastHLine(x, y + j, w, color);
+}
+
+void Arduino_GFX::writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  for(int16_t j = y; j < y + h; j++)
+    for(int16_t i = x; i < x + w; i++)
+      writePixelPreclipped(i, j, color);
+}
+
+void Arduino_GFX::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+  startWrite();
+  writePixel(x, y, color);
+  endWrite();
+}
+
+void Arduino_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+  startWrite();
+  writeFastVLine(x, y, h, color);
+  endWrite();
+}
+
+void Arduino_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+  startWrite();
+  writeFastHLine(x, y, w, color);
+  endWrite();
+}
+
+void Arduino_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  startWrite();
+  writeFillRect(x, y, w, h, color);
+  endWrite();
+}
+
+void Arduino_GFX::fillScreen(uint16_t color)
+{
+  fillRect(0, 0, _width, _height, color);
+}
+
+void Arduino_GFX::setRotation(uint8_t r)
+{
+  rotation = r & 3;
+  _width = (rotation & 1) ? HEIGHT : WIDTH;
+  _height = (rotation & 1) ? WIDTH : HEIGHT;
+}
+
+void Arduino_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+  if(x0 == x1)
+  {
+    drawFastVLine(x0, y0 < y1 ? y0 : y1, abs(y1 - y0) + 1, color);
+    return;
+  }
+  if(y0 == y1)
+  {
+    drawFastHLine(x0 < x1 ? x0 : x1, y0, abs(x1 - x0) + 1, color);
+    return;
+  }
+
+  // Bresenham
+  int16_t dx = abs(x1 - x0), dy = -abs(y1 - y0);
+  int16_t sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+  int16_t err = dx + dy;
+  startWrite();
+  for(;;)
+  {
+    writePixel(x0, y0, color);
+    if(x0 == x1 && y0 == y1)
+      break;
+    int16_t e2 = 2 * err;
+    if(e2 >= dy)
+    {
+      err += dy;
+      x0 += sx;
+    }
+    if(e2 <= dx)
+    {
+      err += dx;
+      y0 += sy;
+    }
+  }
+  endWrite();
+}
+
+void Arduino_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  startWrite();
+  writeFastHLine(x, y, w, color);
+  writeFastHLine(x, y + h - 1, w, color);
+  writeFastVLine(x, y, h, color);
+  writeFastVLine(x + w - 1, y, h, color);
+  endWrite();
+}
+
+void Arduino_GFX::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+  int16_t x = r, y = 0, err = 1 - r;
+  startWrite();
+  while(x >= y)
+  {
+    writePixel(x0 + x, y0 + y, color);
+    writePixel(x0 - x, y0 + y, color);
+    writePixel(x0 + x, y0 - y, color);
+    writePixel(x0 - x, y0 - y, color);
+    writePixel(x0 + y, y0 + x, color);
+    writePixel(x0 - y, y0 + x, color);
+    writePixel(x0 + y, y0 - x, color);
+    writePixel(x0 - y, y0 - x, color);
+    y++;
+    if(err < 0)
+      err += 2 * y + 1;
+    else
+    {
+      x--;
+      err += 2 * (y - x) + 1;
+    }
+  }
+  endWrite();
+}
+
+void Arduino_GFX::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+  int16_t x = r, y = 0, err = 1 - r;
+  startWrite();
+  while(x >= y)
+  {
+    writeFastHLine(x0 - x, y0 + y, 2 * x + 1, color);
+    writeFastHLine(x0 - x, y0 - y, 2 * x + 1, color);
+    writeFastHLine(x0 - y, y0 + x, 2 * y + 1, color);
+    writeFastHLine(x0 - y, y0 - x, 2 * y + 1, color);
+    y++;
+    if(err < 0)
+      err += 2 * y + 1;
+    else
+    {
+      x--;
+      err += 2 * (y - x) + 1;
+    }
+  }
+  endWrite();
+}
+
+void Arduino_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size)
+{
+  if(c < ' ' || c > '~')
+    c = '?';
+  const uint8_t *glyph = font5x7[c - ' '];
+
+  startWrite();
+  for(int8_t i = 0; i < 6; i++)
+  {
+    uint8_t line = i < 5 ? pgm_read_byte(&glyph[i]) : 0;
+    for(int8_t j = 0; j < 8; j++, line >>= 1)
+    {
+      if(!(line & 1) && bg == color)
+        continue;
+      uint16_t pixel = (line & 1) ? color : bg;
+      if(size == 1)
+        writePixel(x + i, y + j, pixel);
+      else
+        writeFillRect(x + i * size, y + j * size, size, size, pixel);
+    }
+  }
+  endWrite();
+}
+
+size_t Arduino_GFX::write(uint8_t c)
+{
+  if(c == '\n')
+  {
+    cursor_x = 0;
+    cursor_y += textsize * 8;
+  }
+  else if(c != '\r')
+  {
+    if(wrap && cursor_x + textsize * 6 > _width)
+    {
+      cursor_x = 0;
+      cursor_y += textsize * 8;
+    }
+    drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
+    cursor_x += textsize * 6;
+  }
+  return 1;
+}
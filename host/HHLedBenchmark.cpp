@@ -0,0 +1,287 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+This is a host benchmark of the drawing, encoding and refresh paths, built
+against the simulated platform (see CMakeLists.txt), to track the cost of
+changes between releases.
+
+Each test is timed for both panel geometries (4 panels as 64x64 and 16 panels
+as 64x256) at each colour depth. A test is repeated until it has run for at
+least the given time, then that is done several times over and the fastest
+and median time per operation are reported, along with the pixels per second
+that gives. The results go to stdout as CSV, or JSON with --json.
+
+The tests cover the same drawing paths as the Benchmark sketch, which can only
+be timed on a device by hand, so they can be compared between releases here.
+
+  HHLedBenchmark [--json] [--trials N] [--min-ms N] [--filter TEXT]
+******************************************************************************/
+#include <HHLedPanel_4x64x16_impl.h>
+#include <HHLedPanel_16x64x16_impl.h>
+#include <HostSimMBI5034.h>
+#include <HHLedPanel.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct Result
+{
+  const char *geometry;
+  uint8_t depth;
+  const char *test;
+  uint32_t iterations;     // Per trial
+  uint32_t pixels;         // Per operation
+  double bestNs;           // Per operation
+  double medianNs;
+};
+
+static bool _json = false;
+static uint32_t _trials = 5;
+static uint32_t _minNs = 20 * 1000000;
+static std::string _filter;
+static std::vector<Result> _results;
+
+static double TimeNs(const std::function<void()> &op, uint32_t iterations)
+{
+  auto start = std::chrono::steady_clock::now();
+  for(uint32_t n = 0; n < iterations; n++)
+    op();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Time one operation touching pixels pixels
+static void Measure(const char *geometry, uint8_t depth, const char *test, uint32_t pixels, const std::function<void()> &op)
+{
+  if(!_filter.empty() && std::string(test).find(_filter) == std::string::npos)
+    return;
+
+  // Double the iterations until a trial takes long enough to time reliably
+  uint32_t iterations = 1;
+  while(TimeNs(op, iterations) < _minNs && iterations < (1u << 30))
+    iterations *= 2;
+
+  std::vector<double> times;
+  for(uint32_t trial = 0; trial < _trials; trial++)
+    times.push_back(TimeNs(op, iterations) / iterations);
+  std::sort(times.begin(), times.end());
+
+  Result result = { geometry, depth, test, iterations, pixels, times.front(), times[times.size() / 2] };
+  _results.push_back(result);
+  fprintf(stderr, "%-10s depth %u %-24s %12.0f ns\n", geometry, depth, test, result.medianNs);
+}
+
+// Run every test on one panel configuration
+template<class PANEL> static void BenchmarkPanel(const char *geometry, uint8_t depth)
+{
+  PANEL *panel = new PANEL();
+  panel->begin();
+  const int16_t width = panel->width(), height = panel->height();
+  const uint32_t area = (uint32_t)width * height;
+
+  // Alternate colours so each operation really changes the frame buffers
+  uint16_t colour = 0;
+  auto next = [&colour]() { colour += 0x1863; return colour; };
+
+  Measure(geometry, depth, "drawPixel", area, [&]() {
+    uint16_t c = next();
+    for(int16_t y = 0; y < height; y++)
+      for(int16_t x = 0; x < width; x++)
+        panel->drawPixel(x, y, c);
+  });
+
+  Measure(geometry, depth, "fillScreen", area, [&]() {
+    panel->fillScreen(next());
+  });
+
+  // The span and rectangle paths, with the text line clears a dashboard does
+  Measure(geometry, depth, "fillRect", area, [&]() {
+    panel->fillRect(0, 0, width, height, next());
+  });
+  Measure(geometry, depth, "fillRect bands", area, [&]() {
+    uint16_t c = next();
+    for(int16_t y = 0; y < height; y += 8)
+      panel->fillRect(0, y, width, 8, c);
+  });
+  Measure(geometry, depth, "drawFastHLine", area, [&]() {
+    uint16_t c = next();
+    for(int16_t y = 0; y < height; y++)
+      panel->drawFastHLine(0, y, width, c);
+  });
+  Measure(geometry, depth, "drawFastVLine", area, [&]() {
+    uint16_t c = next();
+    for(int16_t x = 0; x < width; x++)
+      panel->drawFastVLine(x, 0, height, c);
+  });
+
+  // As used for each line of an AnimatedGIF frame
+  std::vector<uint16_t> line(width);
+  for(int16_t x = 0; x < width; x++)
+    line[x] = x * 273;
+  Measure(geometry, depth, "writePixels", area, [&]() {
+    panel->startWrite();
+    for(int16_t y = 0; y < height; y++)
+    {
+      panel->setAddrWindow(0, y, width, 1);
+      panel->writePixels(line.data(), width, false, false);
+    }
+    panel->endWrite();
+  });
+
+  // The pixel writers of the other rotations, which swap the width and height
+  static const char *const ROTATED[][2] = { { 0, 0 }, { "drawPixel rotation 1", "writePixels rotation 1" },
+                                            { "drawPixel rotation 2", "writePixels rotation 2" },
+                                            { "drawPixel rotation 3", "writePixels rotation 3" } };
+  for(uint8_t rotation = 1; rotation < 4; rotation++)
+  {
+    panel->setRotation(rotation);
+    const int16_t w = panel->width(), h = panel->height();
+    Measure(geometry, depth, ROTATED[rotation][0], area, [&]() {
+      uint16_t c = next();
+      for(int16_t y = 0; y < h; y++)
+        for(int16_t x = 0; x < w; x++)
+          panel->drawPixel(x, y, c);
+    });
+    std::vector<uint16_t> rotatedLine(w);
+    for(int16_t x = 0; x < w; x++)
+      rotatedLine[x] = x * 273;
+    Measure(geometry, depth, ROTATED[rotation][1], area, [&]() {
+      panel->startWrite();
+      for(int16_t y = 0; y < h; y++)
+      {
+        panel->setAddrWindow(0, y, w, 1);
+        panel->writePixels(rotatedLine.data(), w, false, false);
+      }
+      panel->endWrite();
+    });
+  }
+  panel->setRotation(0);
+
+  std::vector<uint8_t> bitmap(area);
+  std::vector<uint16_t> palette(256);
+  for(uint32_t n = 0; n < area; n++)
+    bitmap[n] = n * 7;
+  for(uint32_t n = 0; n < 256; n++)
+    palette[n] = n * 257;
+  Measure(geometry, depth, "drawIndexedBitmap", area, [&]() {
+    panel->drawIndexedBitmap(0, 0, bitmap.data(), palette.data(), width, height);
+  });
+
+  // A screenful of text with a background, as a dashboard would redraw it
+  const uint16_t columns = width / 6, rows = height / 8;
+  std::string text;
+  for(uint16_t n = 0; n < columns; n++)
+    text += (char)('!' + n % 94);
+  Measure(geometry, depth, "print", (uint32_t)columns * rows * 6 * 8, [&]() {
+    panel->setTextColor(next(), 0);
+    for(uint16_t row = 0; row < rows; row++)
+    {
+      panel->setCursor(0, row * 8);
+      panel->print(text.c_str());
+    }
+  });
+
+  Measure(geometry, depth, "clear", area, [&]() {
+    panel->clear();
+  });
+
+  // One whole refresh cycle of what was last drawn, shifted out through the simulated chips
+  panel->fillScreen(0xFFFF);
+  panel->present();
+  HostSimMBI5034::StepFrame();
+  Measure(geometry, depth, "refreshCycle", area, [&]() {
+    HostSimMBI5034::StepFrame();
+  });
+
+  delete panel;
+}
+
+// The 16 panel display at its default height, taking the same template
+// arguments as the 4 panel one
+template<class PLATFORMTYPE, unsigned short COLOUR_DEPTH, uint8_t OPTIONS>
+using HHLedPanel_16x64x16_default = HHLedPanel_16x64x16_impl<PLATFORMTYPE, COLOUR_DEPTH, OPTIONS>;
+
+template<template<class, unsigned short, uint8_t> class IMPL> static void BenchmarkDepths(const char *geometry)
+{
+  BenchmarkPanel<HHLedPanel<IMPL<HostSimMBI5034, 1, 0>>>(geometry, 1);
+  BenchmarkPanel<HHLedPanel<IMPL<HostSimMBI5034, 2, 0>>>(geometry, 2);
+  BenchmarkPanel<HHLedPanel<IMPL<HostSimMBI5034, 3, 0>>>(geometry, 3);
+  BenchmarkPanel<HHLedPanel<IMPL<HostSimMBI5034, 4, 0>>>(geometry, 4);
+  BenchmarkPanel<HHLedPanel<IMPL<HostSimMBI5034, 5, 0>>>(geometry, 5);
+  BenchmarkPanel<HHLedPanel<IMPL<HostSimMBI5034, 6, 0>>>(geometry, 6);
+}
+
+static void WriteCsv()
+{
+  printf("geometry,depth,test,iterations,pixels,best_ns,median_ns,mpixels_per_s\n");
+  for(const Result &r : _results)
+    printf("%s,%u,%s,%u,%u,%.1f,%.1f,%.2f\n", r.geometry, r.depth, r.test, r.iterations, r.pixels,
+      r.bestNs, r.medianNs, r.pixels * 1000.0 / r.medianNs);
+}
+
+static void WriteJson()
+{
+  printf("{\n  \"compiler\": \"%s\",\n  \"trials\": %u,\n  \"results\": [\n", __VERSION__, _trials);
+  for(size_t n = 0; n < _results.size(); n++)
+  {
+    const Result &r = _results[n];
+    printf("    {\"geometry\": \"%s\", \"depth\": %u, \"test\": \"%s\", \"iterations\": %u, \"pixels\": %u, "
+      "\"best_ns\": %.1f, \"median_ns\": %.1f, \"mpixels_per_s\": %.2f}%s\n", r.geometry, r.depth, r.test,
+      r.iterations, r.pixels, r.bestNs, r.medianNs, r.pixels * 1000.0 / r.medianNs, n + 1 < _results.size() ? "," : "");
+  }
+  printf("  ]\n}\n");
+}
+
+int main(int argc, char *argv[])
+{
+  for(int n = 1; n < argc; n++)
+  {
+    std::string arg = argv[n];
+    if(arg == "--json")
+      _json = true;
+    else if(arg == "--csv")
+      _json = false;
+    else if(arg == "--trials" && n + 1 < argc)
+      _trials = std::max(1ul, strtoul(argv[++n], 0, 0));
+    else if(arg == "--min-ms" && n + 1 < argc)
+      _minNs = strtoul(argv[++n], 0, 0) * 1000000;
+    else if(arg == "--filter" && n + 1 < argc)
+      _filter = argv[++n];
+    else
+    {
+      fprintf(stderr, "Usage: %s [--json|--csv] [--trials N] [--min-ms N] [--filter TEXT]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  BenchmarkDepths<HHLedPanel_4x64x16_impl>("4x64x16");
+  BenchmarkDepths<HHLedPanel_16x64x16_default>("16x64x16");
+
+  if(_json)
+    WriteJson();
+  else
+    WriteCsv();
+  return 0;
+}
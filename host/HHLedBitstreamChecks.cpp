@@ -0,0 +1,140 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This is a host runner checking MBI5034Bitstream on its own, over random frames
+at every colour depth, with 1, 2 and 4 blocks and different bit on-times:
+  - a generated stream decodes back to exactly the frame buffers
+  - regenerating one row after changing it gives the same stream as
+    generating the whole frame again
+  - the descriptors cover the whole stream in order and loop back
+  - a stream with its data out of order, or a row shown for too long, doesn't
+    decode back to the frame buffers, so the checks above can fail
+
+  HHLedBitstreamChecks
+
+It prints each check that fails and exits non-zero if any did.
+******************************************************************************/
+#include <MBI5034Bitstream.h>
+#include "HHLedCheck.h"
+#include <vector>
+
+static const uint8_t PLANES = 4;
+static const uint16_t BYTES_PER_BLOCK = 384;
+
+// Random frame buffers, with some rows left blank as drawing often leaves them
+static void RandomFrame(std::vector<byte> &frame, uint16_t bytesToSend)
+{
+  for(uint32_t row = 0; row < frame.size() / bytesToSend; row++)
+  {
+    bool blank = random(4) == 0;
+    for(uint16_t n = 0; n < bytesToSend; n++)
+      frame[row * bytesToSend + n] = blank ? 0 : random(256);
+  }
+}
+
+static void CheckStream(uint8_t colourDepth, uint8_t blocks, uint16_t lsbSamples)
+{
+  const uint16_t bytesToSend = BYTES_PER_BLOCK * blocks;
+  MBI5034Bitstream bitstream(colourDepth, PLANES, bytesToSend, blocks, lsbSamples);
+  std::vector<byte> frame((uint32_t)colourDepth * PLANES * bytesToSend);
+  std::vector<byte> decoded(frame.size());
+  std::vector<uint16_t> samples(bitstream.GetSampleCount());
+  char what[64];
+  snprintf(what, sizeof(what), "depth %u, %u blocks, %u samples per LSB", colourDepth, blocks, lsbSamples);
+
+  RandomFrame(frame, bytesToSend);
+  bitstream.Generate(frame.data(), samples.data());
+  bool valid = bitstream.Decode(samples.data(), samples.size(), decoded.data());
+  HHLedCheck::Check(valid && decoded == frame, "%s: stream %s decode to the frame buffers", what, valid ? "doesn't" : "is invalid, doesn't");
+
+  // Change a row and regenerate just that, against the whole frame again
+  uint8_t depth = random(colourDepth), bank = random(PLANES);
+  for(uint16_t n = 0; n < bytesToSend; n++)
+    frame[(bank + depth * PLANES) * bytesToSend + n] = random(256);
+  bitstream.GenerateRow(frame.data(), samples.data(), depth, bank);
+  std::vector<uint16_t> whole(samples.size());
+  bitstream.Generate(frame.data(), whole.data());
+  HHLedCheck::Check(samples == whole, "%s: regenerating depth %u bank %u differs from the whole frame", what, depth, bank);
+  valid = bitstream.Decode(samples.data(), samples.size(), decoded.data());
+  HHLedCheck::Check(valid && decoded == frame, "%s: regenerated row doesn't decode to the frame buffers", what);
+
+  // The descriptors, split small enough that there are several
+  uint16_t maxSamples = samples.size() / 5 + 1;
+  std::vector<MBI5034DmaDescriptor> descriptors(bitstream.BuildDescriptors(0, 0, maxSamples));
+  bitstream.BuildDescriptors(descriptors.data(), descriptors.size(), maxSamples);
+  uint32_t offset = 0;
+  uint16_t index = 0;
+  bool chained = true;
+  do
+  {
+    chained &= descriptors[index].offset == offset && descriptors[index].length && descriptors[index].length <= maxSamples;
+    offset += descriptors[index].length;
+    index = descriptors[index].next;
+  } while(index && chained && index < descriptors.size());
+  HHLedCheck::Check(chained && !index && offset == samples.size(), "%s: %u descriptors don't cover the %u samples in order",
+        what, (unsigned)descriptors.size(), (unsigned)samples.size());
+
+  // Swap the data of the first two clocks of a lit row, which must then differ
+  uint32_t first = 0;
+  while(first + 1 < bytesToSend && frame[first] == frame[first + 1])
+    first++;
+  if(first + 1 < bytesToSend)
+  {
+    std::vector<uint16_t> swapped(samples);
+    for(uint8_t edge = 0; edge < 2; edge++)
+    {
+      uint16_t a = swapped[first * 2 + edge], b = swapped[first * 2 + 2 + edge];
+      swapped[first * 2 + edge] = (a & ~MBI5034Bitstream::SAMPLE_DATA) | (b & MBI5034Bitstream::SAMPLE_DATA);
+      swapped[first * 2 + 2 + edge] = (b & ~MBI5034Bitstream::SAMPLE_DATA) | (a & MBI5034Bitstream::SAMPLE_DATA);
+    }
+    bitstream.Decode(swapped.data(), swapped.size(), decoded.data());
+    HHLedCheck::Check(decoded != frame, "%s: data out of order still decodes to the frame buffers", what);
+  }
+
+  // Show the first row one sample longer, by enabling the outputs as the next is latched
+  if(lsbSamples > 1)
+  {
+    std::vector<uint16_t> longer(samples);
+    longer[bitstream.GetRowSamples(0) + 2 * bytesToSend] &= ~MBI5034Bitstream::SAMPLE_OE;
+    bool lit = false;
+    for(uint16_t n = 0; n < bytesToSend; n++)
+      lit |= frame[n] != 0;
+    HHLedCheck::Check(!lit || !bitstream.Decode(longer.data(), longer.size(), decoded.data()),
+          "%s: a row shown for too long still decodes as valid", what);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  randomSeed(5034);
+  static const uint8_t BLOCKS[] = { 1, 2, 4 };
+  static const uint16_t LSB_SAMPLES[] = { 1, 3 };
+  for(uint8_t depth = 1; depth <= 6; depth++)
+    for(uint8_t blocks : BLOCKS)
+      for(uint16_t lsbSamples : LSB_SAMPLES)
+        CheckStream(depth, blocks, lsbSamples);
+
+  return HHLedCheck::Report();
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+Host implementation of HHLedCheck, counting and printing checks
+******************************************************************************/
+#include "HHLedCheck.h"
+#include <stdarg.h>
+
+static uint32_t _checks = 0;
+static uint32_t _failures = 0;
+
+bool HHLedCheck::Check(bool ok, const char *format, ...)
+{
+  _checks++;
+  if(ok)
+    return true;
+  _failures++;
+  va_list args;
+  va_start(args, format);
+  printf("FAIL ");
+  vprintf(format, args);
+  printf("\n");
+  va_end(args);
+  return false;
+}
+
+uint32_t HHLedCheck::GetChecks()
+{
+  return _checks;
+}
+
+uint32_t HHLedCheck::GetFailures()
+{
+  return _failures;
+}
+
+int HHLedCheck::Report()
+{
+  printf("%u checks, %u failed\n", _checks, _failures);
+  return _failures ? 1 : 0;
+}
@@ -0,0 +1,44 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+This is the shared fixture of the host check runners: each check is counted,
+any that fail are printed with what was checked, and the runner reports the
+totals at the end, exiting non-zero if any failed so CTest sees it.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+
+class HHLedCheck
+{
+public:
+  // Count a check, printing FAIL and the printf style message if it failed.
+  // Returns ok, to add more detail about a failure.
+  static bool Check(bool ok, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+  static uint32_t GetChecks();
+  static uint32_t GetFailures();
+
+  // Print the totals, returning the exit code for the runner
+  static int Report();
+};
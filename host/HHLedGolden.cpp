@@ -0,0 +1,456 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+This is a host runner checking that every drawing and refresh path puts the
+same pixels on the panels. Each scripted scene is drawn twice, once through
+the normal fast paths (span and rectangle fills, the bulk row encoder, etc.)
+and once on a reference panel that draws everything a pixel at a time with
+drawPixel, for both panel arrangements at every colour depth. Both are read
+back from the bit planes as RGB images, and the fast one has to match:
+  - the reference image
+  - what the simulated platform latched into the chips over a refresh cycle
+  - the frame decoded back from a DMA sample stream (MBI5034Bitstream)
+  - the golden image saved in host/golden for the scene, at colour depth 5
+The scenes are then drawn again on the panel double buffered, with encoded
+output, behind the shadow buffer and power limited, each of which has to
+latch the same image and match the same golden image, as do the panels of
+more than one block with the blocks clocked out 2 and 4 at a time.
+
+  HHLedGolden [--update] [--out DIR]
+
+--update saves the images drawn as the new golden images, after checking
+the rest, and --out saves every image drawn to DIR as PPM to look at.
+The lines, circles and text in the golden images come from the host stand-in
+for Arduino_GFX, so changing it means updating them.
+******************************************************************************/
+#include <HHLedPanel_4x64x16_impl.h>
+#include <HHLedPanel_16x64x16_impl.h>
+#include <HHLedPanel_Shadow_impl.h>
+#include <HostSimMBI5034.h>
+#include <MBI5034Bitstream.h>
+#include <HHLedPanel.h>
+#include "HHLedImage.h"
+#include "HHLedCheck.h"
+#include <string>
+
+#ifndef HHLED_GOLDEN_DIR
+#define HHLED_GOLDEN_DIR "host/golden"
+#endif
+
+// Colour depth the golden images are kept for
+static const uint8_t GOLDEN_DEPTH = 5;
+
+static bool _update = false;
+static std::string _outDir;
+
+// A panel drawing everything through drawPixel, one pixel at a time
+template<class PANELTYPE> class ReferencePanel : public HHLedPanel<PANELTYPE>
+{
+  typedef HHLedPanel<PANELTYPE> Panel;
+  int16_t _windowX = 0, _windowY = 0, _windowW = 0, _windowH = 0;
+  int16_t _x = 0, _y = 0;
+
+public:
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { writeFillRect(x, y, w, 1, color); }
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { writeFillRect(x, y, 1, h, color); }
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { writeFillRect(x, y, w, 1, color); }
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { writeFillRect(x, y, 1, h, color); }
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { writeFillRect(x, y, w, h, color); }
+  void writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { writeFillRect(x, y, w, h, color); }
+  void fillScreen(uint16_t color) { writeFillRect(0, 0, Panel::width(), Panel::height(), color); }
+
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+  {
+    // Negative sizes extend back from x, y as in the GFX libraries
+    if(w < 0)
+    {
+      x += w + 1;
+      w = -w;
+    }
+    if(h < 0)
+    {
+      y += h + 1;
+      h = -h;
+    }
+    for(int16_t j = y; j < y + h; j++)
+      for(int16_t i = x; i < x + w; i++)
+        Panel::drawPixel(i, j, color);
+  }
+
+  void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+  {
+    _windowX = _x = x;
+    _windowY = _y = y;
+    _windowW = w;
+    _windowH = h;
+  }
+
+  void writePixels(uint16_t *colors, uint32_t len, bool block, bool bigEndian)
+  {
+    for(; len && _y < _windowY + _windowH; len--)
+    {
+      uint16_t color = *colors++;
+      Panel::drawPixel(_x, _y, bigEndian ? (color >> 8) | (color << 8) : color);
+      if(++_x >= _windowX + _windowW)
+      {
+        _x = _windowX;
+        _y++;
+      }
+    }
+  }
+
+  void drawIndexedBitmap(int16_t x, int16_t y, uint8_t *bitmap, uint16_t *color_index, int16_t w, int16_t h)
+  {
+    for(int16_t j = 0; j < h; j++)
+      for(int16_t i = 0; i < w; i++)
+        Panel::drawPixel(x + i, y + j, color_index[*bitmap++]);
+  }
+
+  void clear()
+  {
+    Panel::setCursor(0, 0);
+    uint8_t rotation = Panel::getRotation();
+    Panel::setRotation(0);
+    fillScreen(0);
+    Panel::setRotation(rotation);
+  }
+};
+
+// Scenes, drawn on either kind of panel
+
+static uint16_t Colour(uint8_t red, uint8_t green, uint8_t blue)
+{
+  return ((red & 0xf8) << 8) | ((green & 0xfc) << 3) | (blue >> 3);
+}
+
+// Every pixel a different colour from its position, a row at a time through writePixels
+template<class PANEL> void SceneCoordinates(PANEL &panel)
+{
+  uint16_t line[256];
+  for(int16_t y = 0; y < panel.height(); y++)
+  {
+    for(int16_t x = 0; x < panel.width(); x++)
+      line[x] = Colour(x * 4, y, (x ^ y) * 8);
+    panel.setAddrWindow(0, y, panel.width(), 1);
+    panel.writePixels(line, panel.width(), false, false);
+  }
+}
+
+template<class PANEL> void SceneShapes(PANEL &panel)
+{
+  panel.fillScreen(Colour(0, 0, 64));
+  panel.fillRect(-5, -3, 20, 12, Colour(255, 0, 0));
+  panel.fillRect(50, panel.height() - 7, 30, 20, Colour(0, 255, 0));
+  panel.fillRect(30, 30, -9, -5, Colour(255, 255, 0));
+  panel.drawFastHLine(-10, 20, 100, Colour(255, 255, 255));
+  panel.drawFastVLine(3, -4, panel.height() + 8, Colour(0, 255, 255));
+  panel.drawFastVLine(62, 10, 7, Colour(255, 0, 255));
+  panel.drawRect(8, 24, 40, 20, Colour(128, 128, 128));
+  panel.drawLine(0, 0, 63, panel.height() - 1, Colour(255, 128, 0));
+  panel.drawLine(63, 5, 10, 50, Colour(0, 128, 255));
+  panel.drawCircle(40, 40, 15, Colour(200, 100, 50));
+  panel.fillCircle(20, panel.height() - 12, 9, Colour(50, 200, 100));
+}
+
+template<class PANEL> void SceneText(PANEL &panel)
+{
+  panel.setTextColor(Colour(255, 255, 255), Colour(0, 0, 128));
+  panel.setCursor(0, 0);
+  panel.print("Hitchin Hackspace 0123456789");
+  panel.setTextColor(Colour(255, 64, 0));
+  panel.setTextSize(2);
+  panel.setCursor(2, 20);
+  panel.print("HH!");
+  panel.setTextSize(1);
+  panel.setTextColor(Colour(0, 255, 0), 0);
+  panel.setCursor(-4, 40);
+  panel.print("clip");
+  panel.setCursor(40, panel.height() - 4);
+  panel.print("xyz");
+}
+
+template<class PANEL> void SceneBitmaps(PANEL &panel)
+{
+  uint16_t palette[256];
+  for(uint16_t n = 0; n < 256; n++)
+    palette[n] = Colour(n, 255 - n, n * 3);
+  uint8_t bitmap[40 * 30];
+  for(uint16_t n = 0; n < sizeof(bitmap); n++)
+    bitmap[n] = n * 7 + n / 40;
+  panel.drawIndexedBitmap(-8, -6, bitmap, palette, 40, 30);
+  panel.drawIndexedBitmap(40, 30, bitmap, palette, 40, 30);
+
+  // A window filled by several calls, partly off the right edge, with bytes swapped
+  uint16_t pixels[37];
+  for(uint16_t n = 0; n < 37; n++)
+    pixels[n] = Colour(n * 7, 128, 255 - n * 7);
+  panel.startWrite();
+  panel.setAddrWindow(45, 8, 30, 9);
+  for(uint8_t n = 0; n < 8; n++)
+    panel.writePixels(pixels, 37, false, n & 1);
+  panel.endWrite();
+}
+
+template<class PANEL> void SceneRotations(PANEL &panel)
+{
+  uint16_t pixels[20];
+  for(uint8_t rotation = 0; rotation < 4; rotation++)
+  {
+    panel.setRotation(rotation);
+    int16_t x = rotation * 12 + 2;
+    panel.fillRect(x, 2, 10, 14, Colour(255, rotation * 80, 0));
+    panel.drawFastHLine(0, 20 + rotation, panel.width(), Colour(0, 255, rotation * 80));
+    panel.drawFastVLine(x + 4, 0, 40, Colour(rotation * 80, 0, 255));
+    for(uint8_t n = 0; n < 20; n++)
+      pixels[n] = Colour(n * 12, rotation * 60, 100);
+    panel.setAddrWindow(x, 30, 5, 4);
+    panel.writePixels(pixels, 20, false, false);
+    panel.setTextColor(Colour(255, 255, 255));
+    panel.setCursor(x, 40);
+    panel.print((char)('0' + rotation));
+    panel.drawPixel(x + 1, 50, Colour(255, 0, 0));
+
+    // Whole screen rows, running off the right edge
+    uint16_t line[512];
+    for(uint16_t n = 0; n < 512; n++)
+      line[n] = Colour(n * 5, 255 - rotation * 60, n * 3);
+    panel.setAddrWindow(3, 54 + rotation * 2, panel.width(), 2);
+    panel.writePixels(line, 2 * panel.width(), false, rotation & 1);
+  }
+}
+
+template<class PANEL> void SceneClear(PANEL &panel)
+{
+  SceneShapes(panel);
+  panel.setRotation(1);
+  panel.clear();
+  panel.fillRect(4, 4, 8, 8, Colour(255, 255, 255));
+  panel.print("after");
+}
+
+// The panels the scenes are checked on
+template<class IMPL> struct Geometry
+{
+  typedef HHLedPanel<IMPL> Fast;
+  typedef ReferencePanel<IMPL> Reference;
+};
+
+struct Scene
+{
+  const char *name;
+  bool allGeometries;   // Golden image kept for every arrangement, not just the first
+  template<class PANEL> static void Draw(uint8_t scene, PANEL &panel);
+};
+
+static const Scene SCENES[] = {
+  { "coordinates", true },
+  { "shapes", false },
+  { "text", false },
+  { "bitmaps", false },
+  { "rotations", true },
+  { "clear", false },
+};
+
+template<class PANEL> void Scene::Draw(uint8_t scene, PANEL &panel)
+{
+  switch(scene)
+  {
+  case 0: SceneCoordinates(panel); break;
+  case 1: SceneShapes(panel); break;
+  case 2: SceneText(panel); break;
+  case 3: SceneBitmaps(panel); break;
+  case 4: SceneRotations(panel); break;
+  case 5: SceneClear(panel); break;
+  }
+}
+
+static void Check(bool ok, const std::string &what, const HHLedImage &expected, const HHLedImage &actual)
+{
+  int16_t x, y;
+  uint32_t differences = ok ? 0 : expected.Compare(actual, x, y);
+  HHLedCheck::Check(ok, "%s: %u pixels differ, first at %d,%d", what.c_str(), differences, ok ? 0 : x, ok ? 0 : y);
+}
+
+// Compare an image with the golden image kept for the scene, or save it as the new one
+static void CheckGolden(const std::string &name, const std::string &what, const HHLedImage &image, bool update)
+{
+  std::string path = std::string(HHLED_GOLDEN_DIR) + "/" + name + ".ppm";
+  if(update)
+  {
+    if(!image.WritePPM(path.c_str()))
+      printf("Can't write %s\n", path.c_str());
+    return;
+  }
+  HHLedImage golden;
+  if(!golden.ReadPPM(path.c_str()))
+    printf("No golden image %s\n", path.c_str());
+  Check(golden == image, what + " against " + path, golden, image);
+}
+
+// Draw each scene on the plain panel, returning the images drawn for the other
+// builds of the panel to be checked against
+template<class IMPL> std::vector<HHLedImage> RunScenes(const char *geometry, bool first, uint8_t depth, uint16_t bytesToSend, uint8_t blocks)
+{
+  typedef Geometry<IMPL> G;
+  std::vector<HHLedImage> images;
+  for(uint8_t scene = 0; scene < sizeof(SCENES) / sizeof(SCENES[0]); scene++)
+  {
+    std::string name = std::string(geometry) + "_" + SCENES[scene].name;
+    std::string what = name + " depth " + std::to_string(depth);
+
+    // The simulated platform refreshes the panel initialised last, i.e. the fast one
+    typename G::Reference *reference = new typename G::Reference();
+    typename G::Fast *fast = new typename G::Fast();
+    fast->begin();
+    Scene::Draw(scene, *fast);
+    Scene::Draw(scene, *reference);
+
+    HHLedImage image = DecodeImage(*fast, IMPL::WIDTH, IMPL::HEIGHT, depth);
+    HHLedImage expected = DecodeImage(*reference, IMPL::WIDTH, IMPL::HEIGHT, depth);
+    Check(image == expected, what + " against drawPixel", expected, image);
+    images.push_back(image);
+
+    // Refreshed through the model of the chips
+    fast->present();
+    HostSimMBI5034::StepFrame();
+    HostSimMBI5034::StepFrame();
+    HHLedImage latched = DecodeImage(*fast, IMPL::WIDTH, IMPL::HEIGHT, depth, HostSimMBI5034::GetLatchedData());
+    Check(latched == image, what + " as latched", image, latched);
+
+    // and as a DMA sample stream
+    MBI5034Bitstream bitstream(depth, 4, bytesToSend, blocks, 1);
+    std::vector<uint16_t> samples(bitstream.GetSampleCount());
+    std::vector<byte> decoded((uint32_t)depth * 4 * bytesToSend);
+    bitstream.Generate(HostSimMBI5034::GetFrameBuffers(), samples.data());
+    bool valid = bitstream.Decode(samples.data(), samples.size(), decoded.data());
+    HHLedImage streamed = DecodeImage(*fast, IMPL::WIDTH, IMPL::HEIGHT, depth, decoded.data());
+    Check(valid && streamed == image, what + " from the sample stream", image, streamed);
+
+    if(!_outDir.empty())
+      image.WritePPM((_outDir + "/" + name + "_" + std::to_string(depth) + ".ppm").c_str());
+
+    if(depth == GOLDEN_DEPTH && (first || SCENES[scene].allGeometries))
+      CheckGolden(name, what, image, _update);
+
+    delete fast;
+    delete reference;
+  }
+  return images;
+}
+
+// Draw each scene on another build of the panel, e.g. double buffered or with
+// the shadow buffer, and check what the simulated platform latched is what the
+// plain panel drew, and the golden image
+template<class IMPL> void RunVariant(const char *variant, const char *geometry, bool first, uint8_t depth,
+                                     const std::vector<HHLedImage> &images, void (*setup)(HHLedPanel<IMPL> &) = 0)
+{
+  typedef Geometry<IMPL> G;
+  for(uint8_t scene = 0; scene < sizeof(SCENES) / sizeof(SCENES[0]); scene++)
+  {
+    std::string name = std::string(geometry) + "_" + SCENES[scene].name;
+    std::string what = name + " depth " + std::to_string(depth) + " " + variant;
+
+    typename G::Fast *panel = new typename G::Fast();
+    if(setup)
+      setup(*panel);
+    panel->begin();
+    Scene::Draw(scene, *panel);
+    panel->present();
+    HostSimMBI5034::StepFrame();
+    HostSimMBI5034::StepFrame();
+    HHLedImage latched = DecodeImage(*panel, IMPL::WIDTH, IMPL::HEIGHT, depth, HostSimMBI5034::GetLatchedData());
+    Check(latched == images[scene], what + " as latched", images[scene], latched);
+
+    if(depth == GOLDEN_DEPTH && (first || SCENES[scene].allGeometries))
+      CheckGolden(name, what, latched, false);
+
+    delete panel;
+  }
+}
+
+// Well under what the scenes draw, so the governor dims the display
+template<class IMPL> void LimitPower(HHLedPanel<IMPL> &panel)
+{
+  panel.getPowerGovernor().SetBudget(2000);
+}
+
+// The 16 panel display at its default height, taking the same template
+// arguments as the 4 panel one
+template<class PLATFORMTYPE, unsigned short COLOUR_DEPTH, uint8_t OPTIONS>
+using HHLedPanel_16x64x16_default = HHLedPanel_16x64x16_impl<PLATFORMTYPE, COLOUR_DEPTH, OPTIONS>;
+
+template<template<class, unsigned short, uint8_t> class IMPL, unsigned short DEPTH>
+void RunOptions(const char *geometry, bool first, uint16_t bytesToSend, uint8_t blocks)
+{
+  std::vector<HHLedImage> images = RunScenes<IMPL<HostSimMBI5034, DEPTH, 0>>(geometry, first, DEPTH, bytesToSend, blocks);
+  RunVariant<IMPL<HostSimMBI5034, DEPTH, HHLED_DOUBLE_BUFFER>>("double buffered", geometry, first, DEPTH, images);
+  RunVariant<IMPL<HostSimMBI5034, DEPTH, HHLED_ENCODED_OUTPUT>>("encoded", geometry, first, DEPTH, images);
+  RunVariant<IMPL<HostSimMBI5034, DEPTH, HHLED_DOUBLE_BUFFER | HHLED_ENCODED_OUTPUT>>("double buffered encoded", geometry, first, DEPTH, images);
+  RunVariant<HHLedPanel_Shadow_impl<IMPL<HostSimMBI5034, DEPTH, 0>>>("shadowed", geometry, first, DEPTH, images);
+  RunVariant<IMPL<HostSimMBI5034, DEPTH, HHLED_POWER_LIMIT>>("power limited", geometry, first, DEPTH, images,
+                                                            LimitPower<IMPL<HostSimMBI5034, DEPTH, HHLED_POWER_LIMIT>>);
+
+  // With the blocks clocked out in pairs as ESP32_16xWideMBI5034 does, or all
+  // together, refreshing from the frame buffers and from the words
+  for(uint8_t lanes = 2; lanes <= blocks && blocks > 1; lanes *= 2)
+  {
+    std::string variant = std::to_string(lanes) + " blocks in parallel";
+    HostSimMBI5034::SetParallelBlocks(lanes);
+    RunVariant<IMPL<HostSimMBI5034, DEPTH, 0>>(variant.c_str(), geometry, first, DEPTH, images);
+    RunVariant<IMPL<HostSimMBI5034, DEPTH, HHLED_ENCODED_OUTPUT>>((variant + " encoded").c_str(), geometry, first, DEPTH, images);
+  }
+  HostSimMBI5034::SetParallelBlocks(1);
+}
+
+template<template<class, unsigned short, uint8_t> class IMPL> void RunDepths(const char *geometry, bool first, uint16_t bytesToSend, uint8_t blocks)
+{
+  RunOptions<IMPL, 1>(geometry, first, bytesToSend, blocks);
+  RunOptions<IMPL, 2>(geometry, first, bytesToSend, blocks);
+  RunOptions<IMPL, 3>(geometry, first, bytesToSend, blocks);
+  RunOptions<IMPL, 4>(geometry, first, bytesToSend, blocks);
+  RunOptions<IMPL, 5>(geometry, first, bytesToSend, blocks);
+  RunOptions<IMPL, 6>(geometry, first, bytesToSend, blocks);
+}
+
+int main(int argc, char *argv[])
+{
+  for(int n = 1; n < argc; n++)
+  {
+    std::string arg = argv[n];
+    if(arg == "--update")
+      _update = true;
+    else if(arg == "--out" && n + 1 < argc)
+      _outDir = argv[++n];
+    else
+    {
+      fprintf(stderr, "Usage: %s [--update] [--out DIR]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  RunDepths<HHLedPanel_4x64x16_impl>("4x64x16", true, 384, 1);
+  RunDepths<HHLedPanel_16x64x16_default>("16x64x16", false, 384 * 4, 4);
+
+  return HHLedCheck::Report();
+}
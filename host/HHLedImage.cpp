@@ -0,0 +1,81 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+Host implementation of HHLedImage, saving and loading binary PPM files
+******************************************************************************/
+#include "HHLedImage.h"
+
+uint32_t HHLedImage::Compare(const HHLedImage &other, int16_t &x, int16_t &y) const
+{
+  x = y = -1;
+  if(width != other.width || height != other.height)
+  {
+    x = y = 0;
+    return (uint32_t)(width > other.width ? width : other.width) * (height > other.height ? height : other.height);
+  }
+
+  uint32_t differences = 0;
+  for(uint32_t n = 0; n < (uint32_t)width * height; n++)
+  {
+    if(memcmp(&rgb[n * 3], &other.rgb[n * 3], 3))
+    {
+      if(!differences++)
+      {
+        x = n % width;
+        y = n / width;
+      }
+    }
+  }
+  return differences;
+}
+
+bool HHLedImage::WritePPM(const char *path) const
+{
+  FILE *file = fopen(path, "wb");
+  if(!file)
+    return false;
+  fprintf(file, "P6\n%u %u\n255\n", width, height);
+  bool written = fwrite(rgb.data(), 1, rgb.size(), file) == rgb.size();
+  return fclose(file) == 0 && written;
+}
+
+bool HHLedImage::ReadPPM(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  if(!file)
+    return false;
+
+  // Only the binary form written above, without comments
+  unsigned w, h, maxval;
+  bool read = fscanf(file, "P6 %u %u %u", &w, &h, &maxval) == 3 && maxval == 255 && fgetc(file) != EOF;
+  if(read)
+  {
+    width = w;
+    height = h;
+    rgb.resize((uint32_t)w * h * 3);
+    read = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+  }
+  fclose(file);
+  return read;
+}
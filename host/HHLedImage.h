@@ -0,0 +1,80 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+This is a host helper to turn what is drawn on a set of panels back into an
+RGB image, by reading the bit planes of each pixel with decodePixel, and to
+save and load images as binary PPM files to look at or compare against.
+
+Each colour level, after gamma correction, is scaled up to 0-255, so images
+are only comparable between displays with the same colour depth.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+struct HHLedImage
+{
+  uint16_t width = 0;
+  uint16_t height = 0;
+  std::vector<uint8_t> rgb;   // 3 bytes per pixel, row by row
+
+  HHLedImage() {}
+  HHLedImage(uint16_t w, uint16_t h) : width(w), height(h), rgb((uint32_t)w * h * 3) {}
+
+  bool operator==(const HHLedImage &other) const
+  {
+    return width == other.width && height == other.height && rgb == other.rgb;
+  }
+
+  bool operator!=(const HHLedImage &other) const
+  {
+    return !(*this == other);
+  }
+
+  // Pixels that differ, and the first of them if any (x, y set to -1 if none)
+  uint32_t Compare(const HHLedImage &other, int16_t &x, int16_t &y) const;
+
+  bool WritePPM(const char *path) const;
+  bool ReadPPM(const char *path);
+};
+
+// Decode the panels at colourDepth, width x height in panel coordinates, from
+// the frame being drawn on or the frame buffers given
+template<class PANEL> HHLedImage DecodeImage(const PANEL &panel, uint16_t width, uint16_t height, uint8_t colourDepth, const byte *frame = 0)
+{
+  HHLedImage image(width, height);
+  const uint16_t top = (1 << colourDepth) - 1;
+  uint8_t *p = image.rgb.data();
+  for(int16_t y = 0; y < height; y++)
+  {
+    for(int16_t x = 0; x < width; x++)
+    {
+      uint8_t levels[3];
+      panel.decodePixel(x, y, levels, frame);
+      for(uint8_t colour = 0; colour < 3; colour++)
+        *p++ = levels[colour] * 255 / top;
+    }
+  }
+  return image;
+}
@@ -0,0 +1,193 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+This is a host runner checking the power limiting of HHLED_POWER_LIMIT on the
+simulated platform, with full white and blank frames on 4 panels at 100%:
+  - the current estimated once turned down stays within the budget, and so
+    does the current worked out from the gain and on-times actually shown
+  - the display is turned back up at the rise rate set once the content
+    allows
+  - limiting by the current gain goes down to 12%, then hands over to dimming
+  - double buffered, the dimming only changes as the frame it was worked out
+    for is shown, so the frame before isn't shown any brighter meanwhile
+
+  HHLedPowerChecks
+
+It prints each check that fails and exits non-zero if any did.
+******************************************************************************/
+#include <HHLedPanel_4x64x16_impl.h>
+#include <HostSimMBI5034.h>
+#include <HHLedPanel.h>
+#include "HHLedCheck.h"
+
+static const uint8_t COLOUR_DEPTH = 5;
+static const uint16_t PANELS = 4;
+static const uint32_t BUDGET_mA = 10000;
+
+typedef HHLedPanel<HHLedPanel_4x64x16_impl<HostSimMBI5034, COLOUR_DEPTH, HHLED_POWER_LIMIT>> SinglePanel;
+typedef HHLedPanel<HHLedPanel_4x64x16_impl<HostSimMBI5034, COLOUR_DEPTH, HHLED_POWER_LIMIT | HHLED_DOUBLE_BUFFER>> DoublePanel;
+
+// Time the outputs are enabled for over the next refresh cycle, all bits together
+static uint64_t MeasureOnTime()
+{
+  uint64_t start = 0;
+  for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+    start += HostSimMBI5034::GetOnTime(depth);
+  HostSimMBI5034::StepFrame();
+  uint64_t end = 0;
+  for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+    end += HostSimMBI5034::GetOnTime(depth);
+  return end - start;
+}
+
+// Current drawn showing the frame last estimated at 100%, from the gain written
+// to the chips and the share of the full on-time the outputs were enabled for
+static uint32_t ShownCurrent(const HHLedPowerGovernor &governor, uint64_t onTime, uint64_t fullOnTime)
+{
+  const uint32_t idle_mA = PANELS * HHLedPowerGovernor::DEFAULT_IDLE_mA;
+  return idle_mA + (governor.GetEstimate() - idle_mA) * HostSimMBI5034::GetBrightness() * onTime / (100 * fullOnTime);
+}
+
+// Full white goes over budget and is turned down straight away, then a blank
+// frame is turned back up a step at a time
+static void CheckDimming(uint16_t riseRate)
+{
+  SinglePanel *panel = new SinglePanel(100);
+  HHLedPowerGovernor &governor = panel->getPowerGovernor();
+  panel->begin();
+  panel->fillScreen(0xffff);
+  panel->commit();
+  HostSimMBI5034::StepFrame();
+  uint64_t fullOnTime = MeasureOnTime();
+
+  governor.SetBudget(BUDGET_mA);
+  governor.SetRiseRate(riseRate);
+  panel->commit();
+  HHLedCheck::Check(governor.GetScale() < HHLedPowerGovernor::FULL_SCALE && governor.GetLimitedEstimate(PANELS) <= BUDGET_mA,
+        "white at rise rate %u estimated at %umA turned down to %u", riseRate, governor.GetLimitedEstimate(PANELS), governor.GetScale());
+  HostSimMBI5034::StepFrame();
+  uint32_t current = ShownCurrent(governor, MeasureOnTime(), fullOnTime);
+  HHLedCheck::Check(current <= BUDGET_mA, "white at rise rate %u shown drawing %umA", riseRate, current);
+
+  // Each blank frame covers its share of the way back up, rounded up
+  panel->fillScreen(0);
+  for(uint16_t frame = 0; governor.GetScale() < HHLedPowerGovernor::FULL_SCALE && frame < HHLedPowerGovernor::FULL_SCALE; frame++)
+  {
+    uint16_t scale = governor.GetScale();
+    uint16_t expected = scale + ((HHLedPowerGovernor::FULL_SCALE - scale) * riseRate + HHLedPowerGovernor::FULL_SCALE - 1) / HHLedPowerGovernor::FULL_SCALE;
+    panel->commit();
+    HHLedCheck::Check(governor.GetScale() == expected && governor.GetLimitedEstimate(PANELS) <= BUDGET_mA,
+          "blank at rise rate %u frame %u turned up from %u to %u, not %u", riseRate, frame, scale, governor.GetScale(), expected);
+  }
+  HHLedCheck::Check(governor.GetScale() == HHLedPowerGovernor::FULL_SCALE, "blank at rise rate %u never turned back up", riseRate);
+
+  delete panel;
+}
+
+// Limited by the current gain, down to 12% on its own, then dimmed beyond that
+static void CheckGain(uint32_t budget_mA, bool dimmed)
+{
+  SinglePanel *panel = new SinglePanel(100);
+  HHLedPowerGovernor &governor = panel->getPowerGovernor();
+  panel->begin();
+  panel->fillScreen(0xffff);
+  panel->commit();
+  HostSimMBI5034::StepFrame();
+  uint64_t fullOnTime = MeasureOnTime();
+
+  governor.SetBudget(budget_mA, true);
+  panel->commit();
+  HostSimMBI5034::StepFrame();
+  uint64_t onTime = MeasureOnTime();
+  uint16_t gain = HostSimMBI5034::GetBrightness();
+  HHLedCheck::Check(gain >= HHLedPowerGovernor::MIN_GAIN_PERCENT && gain < 100, "white limited to %umA by gain at %u%%", budget_mA, gain);
+  if(dimmed)
+    HHLedCheck::Check(gain == HHLedPowerGovernor::MIN_GAIN_PERCENT && onTime < fullOnTime, "white limited to %umA by gain at %u%%, on for %llu of %llu ticks",
+          budget_mA, gain, (unsigned long long)onTime, (unsigned long long)fullOnTime);
+  else
+    HHLedCheck::Check(onTime == fullOnTime, "white limited to %umA dimmed when the gain at %u%% was enough", budget_mA, gain);
+  uint32_t current = ShownCurrent(governor, onTime, fullOnTime);
+  HHLedCheck::Check(current <= budget_mA, "white limited to %umA by gain shown drawing %umA", budget_mA, current);
+
+  delete panel;
+}
+
+// Double buffered, a blank frame drawn after a white one mustn't turn the
+// display up while the white one is still being shown
+static void CheckDoubleBuffered()
+{
+  DoublePanel *panel = new DoublePanel(100);
+  HHLedPowerGovernor &governor = panel->getPowerGovernor();
+  panel->begin();
+  panel->fillScreen(0xffff);
+  panel->present();
+  HostSimMBI5034::StepFrame();
+  uint64_t fullOnTime = MeasureOnTime();
+
+  governor.SetBudget(BUDGET_mA);
+  governor.SetRiseRate(HHLedPowerGovernor::FULL_SCALE);
+  panel->present();
+  uint64_t whiteOnTime = MeasureOnTime();
+  uint32_t current = ShownCurrent(governor, whiteOnTime, fullOnTime);
+  HHLedCheck::Check(whiteOnTime < fullOnTime && current <= BUDGET_mA, "double buffered white shown drawing %umA", current);
+
+  // Drawn and committed, but not shown yet
+  panel->fillScreen(0);
+  panel->commit();
+  uint64_t onTime = MeasureOnTime();
+  HHLedCheck::Check(onTime == whiteOnTime, "double buffered white on for %llu ticks after committing blank, not %llu",
+        (unsigned long long)onTime, (unsigned long long)whiteOnTime);
+
+  // Presenting it waits out the rest of the cycle of white, which has to stay dimmed
+  uint64_t start = 0, end = 0;
+  for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+    start += HostSimMBI5034::GetOnTime(depth);
+  panel->present();
+  for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+    end += HostSimMBI5034::GetOnTime(depth);
+  HHLedCheck::Check(end - start <= whiteOnTime, "double buffered white on for %llu ticks while blank was presented, not %llu",
+        (unsigned long long)(end - start), (unsigned long long)whiteOnTime);
+  HHLedCheck::Check(governor.GetScale() == HHLedPowerGovernor::FULL_SCALE, "double buffered blank shown turned down to %u", governor.GetScale());
+
+  // and white again is turned down from the moment it is shown
+  panel->fillScreen(0xffff);
+  panel->present();
+  onTime = MeasureOnTime();
+  HHLedCheck::Check(onTime == whiteOnTime, "double buffered white on for %llu ticks once presented again, not %llu",
+        (unsigned long long)onTime, (unsigned long long)whiteOnTime);
+
+  delete panel;
+}
+
+int main(int argc, char *argv[])
+{
+  CheckDimming(16);
+  CheckDimming(1);
+  CheckDimming(HHLedPowerGovernor::FULL_SCALE);
+  CheckGain(BUDGET_mA, false);
+  CheckGain(4000, true);
+  CheckDoubleBuffered();
+
+  return HHLedCheck::Report();
+}
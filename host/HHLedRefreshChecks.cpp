@@ -0,0 +1,311 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+This is a host runner checking the timing of the refresh on the simulated
+platform, i.e. how long the outputs are enabled for each bit over a refresh
+cycle, for the 4 panel arrangement at every colour depth:
+  - each bit is on for exactly twice as long as the next, as the schedule
+    has it, and within rounding of that when dimmed
+  - the same with heavy bits split up by SetMaxBitWeight, including weights
+    that aren't a power of two, with the schedule as MBI5034RefreshCost
+    models it
+  - rows with nothing lit are skipped, exactly those the schedule has for a
+    blank bit plane, while what is latched stays the same as what was drawn
+  - dimming never lights a bit for longer at a lower level, and turns it off
+    at 0
+
+  HHLedRefreshChecks
+
+It prints each check that fails and exits non-zero if any did.
+******************************************************************************/
+#include <HHLedPanel_4x64x16_impl.h>
+#include <HostSimMBI5034.h>
+#include <HHLedPanel.h>
+#include "HHLedCheck.h"
+#include <string>
+#include <algorithm>
+#include <stdint.h>
+
+// Time the outputs are enabled for each bit over the next whole refresh cycle
+static void MeasureOnTimes(uint8_t colourDepth, uint64_t onTimes[])
+{
+  // Finish the cycle under way first, it may have started with other settings
+  HostSimMBI5034::StepFrame();
+  for(uint8_t depth = 0; depth < colourDepth; depth++)
+    onTimes[depth] = HostSimMBI5034::GetOnTime(depth);
+  HostSimMBI5034::StepFrame();
+  for(uint8_t depth = 0; depth < colourDepth; depth++)
+    onTimes[depth] = HostSimMBI5034::GetOnTime(depth) - onTimes[depth];
+}
+
+// Rows of a bit shown per refresh cycle, according to the schedule
+static uint16_t CountSteps(uint8_t depth)
+{
+  const MBI5034Schedule &schedule = HostSimMBI5034::GetSchedule();
+  uint16_t steps = 0;
+  for(uint16_t step = 0; step < schedule.GetStepCount(); step++)
+    steps += schedule.GetStep(step).depth == depth;
+  return steps;
+}
+
+// Each bit has to be on for twice as long as the next over a cycle. Dimmed,
+// each row's on-time is rounded down to a whole tick, so the two can be out by
+// up to a tick for every row of either bit, and rows of a tick or so go dark.
+static void CheckWeights(const char *what, uint8_t colourDepth, uint8_t planes, bool dimmed)
+{
+  const MBI5034Schedule &schedule = HostSimMBI5034::GetSchedule();
+  uint64_t onTimes[6];
+  MeasureOnTimes(colourDepth, onTimes);
+  uint64_t start = HostSimMBI5034::GetTime();
+  HostSimMBI5034::StepFrame();
+  uint64_t cycle = HostSimMBI5034::GetTime() - start;
+  if(!dimmed)
+    HHLedCheck::Check(cycle == schedule.GetFrameTicks(), "depth %u %s cycle took %llu ticks, scheduled for %u",
+          colourDepth, what, (unsigned long long)cycle, schedule.GetFrameTicks());
+
+  for(uint8_t depth = 0; depth < colourDepth; depth++)
+  {
+    if(!dimmed)
+      HHLedCheck::Check(onTimes[depth] == (uint64_t)schedule.GetOnTicks(depth) * planes, "depth %u %s bit %u on for %llu ticks, scheduled for %u per row",
+            colourDepth, what, depth, (unsigned long long)onTimes[depth], schedule.GetOnTicks(depth));
+    if(depth + 1 == colourDepth)
+      break;
+    uint64_t twice = onTimes[depth + 1] * 2;
+    uint64_t error = twice > onTimes[depth] ? twice - onTimes[depth] : onTimes[depth] - twice;
+    uint64_t allowed = dimmed ? CountSteps(depth) + 2 * CountSteps(depth + 1) : 0;
+    HHLedCheck::Check((dimmed || onTimes[depth + 1]) && error <= allowed, "depth %u %s bit %u on for %llu ticks, bit %u for %llu",
+          colourDepth, what, depth, (unsigned long long)onTimes[depth], depth + 1, (unsigned long long)onTimes[depth + 1]);
+  }
+}
+
+// Split the heavy bits up, checking the weights still hold and the cost model
+// expects the rows and time the simulated refresh takes
+static void CheckSplitting(uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend)
+{
+  static const uint8_t WEIGHTS[] = { 1, 2, 3, 4, 5, 6, 8, 12, 16, 31, 32 };
+  for(uint8_t maxWeight : WEIGHTS)
+  {
+    std::string what = "max weight " + std::to_string(maxWeight);
+    HostSimMBI5034::SetMaxBitWeight(maxWeight);
+    CheckWeights(what.c_str(), colourDepth, planes, false);
+
+    const MBI5034Schedule &schedule = HostSimMBI5034::GetSchedule();
+    MBI5034RefreshCost cost(colourDepth, planes, bytesToSend, HostSimMBI5034::SIM_REFRESH_INTERVAL_uS, HostSimMBI5034::SIM_TICKS_PER_uS,
+                            HostSimMBI5034::SIM_SHIFT_TICKS_PER_CLOCK * 1000 / HostSimMBI5034::SIM_TICKS_PER_uS, maxWeight);
+    HHLedCheck::Check(cost.GetRowsPerFrame() == schedule.GetStepCount() && cost.GetFrameTicks() == schedule.GetFrameTicks(),
+          "depth %u %s modelled as %u rows and %u ticks, scheduled as %u and %u", colourDepth, what.c_str(),
+          cost.GetRowsPerFrame(), cost.GetFrameTicks(), schedule.GetStepCount(), schedule.GetFrameTicks());
+
+    // Each round starts with the first plane of the top bit, and the rounds
+    // should be the same length give or take one chunk
+    uint8_t chunk = 1 << (colourDepth - 1);
+    while(chunk > maxWeight)
+      chunk >>= 1;
+    uint32_t longest = 0, shortest = UINT32_MAX, length = 0;
+    for(uint16_t step = 0; step <= schedule.GetStepCount(); step++)
+    {
+      if(step == schedule.GetStepCount() || (step && !schedule.GetStep(step).depth && !schedule.GetStep(step).bank))
+      {
+        longest = std::max(longest, length);
+        shortest = std::min(shortest, length);
+        length = 0;
+      }
+      if(step < schedule.GetStepCount())
+        length += schedule.GetStep(step).weight;
+    }
+    HHLedCheck::Check(longest - shortest <= (uint32_t)planes * chunk, "depth %u %s rounds from %u to %u long",
+          colourDepth, what.c_str(), shortest, longest);
+
+    what += " dimmed";
+    HostSimMBI5034::SetDimming(100);
+    CheckWeights(what.c_str(), colourDepth, planes, true);
+    HostSimMBI5034::SetDimming(255);
+  }
+  HostSimMBI5034::SetMaxBitWeight(0);
+}
+
+// Step a refresh cycle of what has been drawn, checking the rows skipped are
+// those with nothing lit and are left dark, and the rows shown still latch
+// exactly the frame buffers
+template<class PANEL> void CheckSkipped(PANEL &panel, const char *what, uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend)
+{
+  panel.present();
+  HostSimMBI5034::StepFrame();
+  uint32_t skipped = HostSimMBI5034::GetSkippedRows();
+  uint64_t onTimes[6];
+  for(uint8_t depth = 0; depth < colourDepth; depth++)
+    onTimes[depth] = HostSimMBI5034::GetOnTime(depth);
+  HostSimMBI5034::StepFrame();
+  skipped = HostSimMBI5034::GetSkippedRows() - skipped;
+
+  const MBI5034Schedule &schedule = HostSimMBI5034::GetSchedule();
+  const byte *frame = HostSimMBI5034::GetFrameBuffers();
+  const byte *latched = HostSimMBI5034::GetLatchedData();
+  uint32_t blank = 0, differing = 0;
+  uint64_t expected[6] = {0};
+  for(uint16_t step = 0; step < schedule.GetStepCount(); step++)
+  {
+    uint32_t offset = (schedule.GetStep(step).depth * planes + schedule.GetStep(step).bank) * bytesToSend;
+    uint16_t n = 0;
+    while(n < bytesToSend && !frame[offset + n])
+      n++;
+    if(n == bytesToSend)
+    {
+      blank++;
+      continue;
+    }
+    differing += memcmp(latched + offset, frame + offset, bytesToSend) != 0;
+    expected[schedule.GetStep(step).depth] += schedule.GetStepTicks(step);
+  }
+  HHLedCheck::Check(skipped == blank, "depth %u %s skipped %u rows, %u blank", colourDepth, what, skipped, blank);
+  HHLedCheck::Check(!differing, "depth %u %s latched %u rows shown differently", colourDepth, what, differing);
+
+  // Only the rows shown count towards the on-time of their bit
+  for(uint8_t depth = 0; depth < colourDepth; depth++)
+  {
+    uint64_t onTime = HostSimMBI5034::GetOnTime(depth) - onTimes[depth];
+    HHLedCheck::Check(onTime == expected[depth], "depth %u %s bit %u on for %llu ticks, %llu shown",
+          colourDepth, what, depth, (unsigned long long)onTime, (unsigned long long)expected[depth]);
+  }
+}
+
+// Draw sparser and fuller scenes, so rows are skipped and then shown again
+template<class PANEL> void CheckSkipping(PANEL &panel, uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend)
+{
+  panel.fillScreen(0);
+  CheckSkipped(panel, "blank", colourDepth, planes, bytesToSend);
+  HHLedCheck::Check(HostSimMBI5034::GetSkippedRows() > 0, "depth %u nothing skipped", colourDepth);
+  panel.drawPixel(5, 3, 0xffff);
+  CheckSkipped(panel, "one pixel", colourDepth, planes, bytesToSend);
+  panel.drawFastHLine(0, 40, 64, PANEL::make_colour(255, 0, 0));
+  panel.drawFastHLine(0, 41, 64, PANEL::make_colour(0, 40, 0));
+  CheckSkipped(panel, "two lines", colourDepth, planes, bytesToSend);
+  panel.drawPixel(5, 3, 0);
+  CheckSkipped(panel, "one pixel cleared", colourDepth, planes, bytesToSend);
+  panel.fillScreen(0xffff);
+  CheckSkipped(panel, "full", colourDepth, planes, bytesToSend);
+}
+
+// Every bit has to be on for no longer at each lower dimming level, so a level
+// too low for the shortest bits leaves them dark rather than fully on
+template<class PANEL> void CheckDimming(PANEL &panel, uint8_t colourDepth)
+{
+  uint64_t last[6] = {};
+  for(int16_t level = 255; level >= 0; level--)
+  {
+    uint64_t onTimes[6];
+    panel.setDimming(level);
+    MeasureOnTimes(colourDepth, onTimes);
+    for(uint8_t depth = 0; depth < colourDepth; depth++)
+    {
+      if(level == 0)
+        HHLedCheck::Check(onTimes[depth] == 0, "depth %u bit %u on for %llu ticks when dimmed to 0",
+              colourDepth, depth, (unsigned long long)onTimes[depth]);
+      else if(level < 255)
+        HHLedCheck::Check(onTimes[depth] <= last[depth], "depth %u bit %u on for %llu ticks at dimming %d, %llu at %d",
+              colourDepth, depth, (unsigned long long)onTimes[depth], level, (unsigned long long)last[depth], level + 1);
+      last[depth] = onTimes[depth];
+    }
+  }
+  panel.setDimming(255);
+}
+
+// Encoded, the refresh shows the words as they were until commit(), so clearing
+// the screen mustn't start skipping the rows still lit on them before then
+template<unsigned short COLOUR_DEPTH> void CheckEncodedFills()
+{
+  HHLedPanel<HHLedPanel_4x64x16_impl<HostSimMBI5034, COLOUR_DEPTH, HHLED_ENCODED_OUTPUT>> *panel =
+    new HHLedPanel<HHLedPanel_4x64x16_impl<HostSimMBI5034, COLOUR_DEPTH, HHLED_ENCODED_OUTPUT>>();
+  panel->begin();
+  panel->fillScreen(0xffff);
+  panel->commit();
+  HostSimMBI5034::StepFrame();
+
+  static const char *const WHAT[] = { "filled", "cleared" };
+  for(const char *what : WHAT)
+  {
+    if(what == WHAT[0])
+      panel->fillScreen(0);
+    else
+      panel->clear();
+    uint32_t skipped = HostSimMBI5034::GetSkippedRows();
+    HostSimMBI5034::StepFrame();
+    skipped = HostSimMBI5034::GetSkippedRows() - skipped;
+    HHLedCheck::Check(!skipped, "depth %u encoded %s skipped %u rows before commit()", COLOUR_DEPTH, what, skipped);
+
+    panel->commit();
+    skipped = HostSimMBI5034::GetSkippedRows();
+    HostSimMBI5034::StepFrame();
+    skipped = HostSimMBI5034::GetSkippedRows() - skipped;
+    HHLedCheck::Check(skipped == HostSimMBI5034::GetSchedule().GetStepCount(), "depth %u encoded %s skipped %u of %u rows after commit()",
+          COLOUR_DEPTH, what, skipped, HostSimMBI5034::GetSchedule().GetStepCount());
+
+    panel->fillScreen(0xffff);
+    panel->commit();
+    HostSimMBI5034::StepFrame();
+  }
+
+  delete panel;
+}
+
+template<unsigned short COLOUR_DEPTH> void RunDepth()
+{
+  // Every LED lit, so no rows are skipped
+  HHLedPanel<HHLedPanel_4x64x16_impl<HostSimMBI5034, COLOUR_DEPTH>> *panel = new HHLedPanel<HHLedPanel_4x64x16_impl<HostSimMBI5034, COLOUR_DEPTH>>();
+  panel->begin();
+  panel->fillScreen(0xffff);
+  panel->present();
+  uint8_t levels[3];
+  panel->decodePixel(17, 42, levels);
+  HHLedCheck::Check(levels[0] == (1 << COLOUR_DEPTH) - 1 && levels[1] == levels[0] && levels[2] == levels[0],
+        "depth %u white filled as %u,%u,%u", COLOUR_DEPTH, levels[0], levels[1], levels[2]);
+
+  CheckWeights("full", COLOUR_DEPTH, 4, false);
+  static const uint8_t LEVELS[] = { 200, 128, 37 };
+  for(uint8_t level : LEVELS)
+  {
+    std::string what = "dimmed to " + std::to_string(level);
+    panel->setDimming(level);
+    CheckWeights(what.c_str(), COLOUR_DEPTH, 4, true);
+  }
+  panel->setDimming(255);
+  CheckDimming(*panel, COLOUR_DEPTH);
+  CheckSplitting(COLOUR_DEPTH, 4, 384);
+  CheckSkipping(*panel, COLOUR_DEPTH, 4, 384);
+
+  delete panel;
+  CheckEncodedFills<COLOUR_DEPTH>();
+}
+
+int main(int argc, char *argv[])
+{
+  RunDepth<1>();
+  RunDepth<2>();
+  RunDepth<3>();
+  RunDepth<4>();
+  RunDepth<5>();
+  RunDepth<6>();
+
+  return HHLedCheck::Report();
+}
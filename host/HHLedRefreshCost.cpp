@@ -0,0 +1,87 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+This is a host tool to report what refreshing each arrangement of panels costs
+at each colour depth, from MBI5034RefreshCost, to choose a configuration
+without trial and error on the hardware.
+
+The timing defaults to that in ESP32_4xMBI5034_Pins.h, and the GPIO write
+rate to about 20 million a second, as measured for the ESP32 (the 768 writes
+to clock out 384 outputs take about 39uS).
+
+  HHLedRefreshCost [--interval-us N] [--ticks-per-us N] [--shift-ns N]
+                   [--max-weight N] [--bus-mhz N]
+******************************************************************************/
+#include <MBI5034RefreshCost.h>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+  uint32_t intervalUs = 6000, ticksPerUs = 10, shiftNs = 100, busWrites = 20000000;
+  uint8_t maxWeight = 0;
+  for(int n = 1; n < argc; n += 2)
+  {
+    std::string arg = argv[n];
+    uint32_t value = n + 1 < argc ? strtoul(argv[n + 1], 0, 0) : 0;
+    if(arg == "--interval-us" && value)
+      intervalUs = value;
+    else if(arg == "--ticks-per-us" && value)
+      ticksPerUs = value;
+    else if(arg == "--shift-ns" && value)
+      shiftNs = value;
+    else if(arg == "--max-weight" && n + 1 < argc)
+      maxWeight = value;
+    else if(arg == "--bus-mhz" && value)
+      busWrites = value * 1000000;
+    else
+    {
+      fprintf(stderr, "Usage: %s [--interval-us N] [--ticks-per-us N] [--shift-ns N] [--max-weight N] [--bus-mhz N]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  printf("Refresh interval %uuS, %u ticks/uS, %unS per clock, max bit weight %u, %u GPIO writes/s\n\n",
+    intervalUs, ticksPerUs, shiftNs, maxWeight, busWrites);
+  printf("panels driver  depth meets rows/frame writes/row writes/frame writes/s    scheduled_hz real_hz duty%% max_hz\n");
+
+  // 2 chips of 96 outputs per data line on each panel, and up to 4 panels to a block
+  static const uint16_t BYTES_PER_BLOCK = 384;
+  for(uint8_t blocks = 1; blocks <= 4; blocks++)
+  {
+    for(uint8_t wide = 0; wide <= (blocks > 1 ? 1 : 0); wide++)
+    {
+      uint32_t clocks = (uint32_t)(wide ? (blocks + 1) / 2 : blocks) * BYTES_PER_BLOCK;
+      for(uint8_t depth = 1; depth <= 6; depth++)
+      {
+        MBI5034RefreshCost cost(depth, 4, clocks, intervalUs, ticksPerUs, shiftNs, maxWeight);
+        printf("%-6u %-7s %-5u %-5s %-10u %-10u %-12llu %-13llu %-12u %-7u %-5u %u\n",
+          blocks * 4, wide ? "16xWide" : blocks > 1 ? "16x" : "4x", depth, cost.MeetsTarget() ? "yes" : "NO",
+          cost.GetRowsPerFrame(), cost.GetWritesPerRow(), (unsigned long long)cost.GetWritesPerFrame(),
+          (unsigned long long)cost.GetWritesPerSecond(), cost.GetRefreshRate(), cost.GetRefreshRate(busWrites),
+          cost.GetDutyPercent(busWrites), cost.GetMaxRefreshRate(busWrites));
+      }
+    }
+  }
+  return 0;
+}
@@ -32,18 +32,34 @@ rows) per interrupt and allows up to a 5-bit colour depth to be used.
 ******************************************************************************/
 #pragma once
 #include <Arduino.h>
+#include "ESP32_MBI5034Refresh.h"
+#include "MBI5034RefreshCost.h"
 
-class ESP32_16xMBI5034
+class ESP32_16xMBI5034 : public ESP32_MBI5034Refresh<ESP32_16xMBI5034>
 {
 public:
-  static void Initialise(byte *frameBuffers, uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend);
-  
-  // Currently this mus be called after Initialise and before StartDisplay
-  static void SetBrightness(uint16_t brighnessPercent);
+  // Up to 4 blocks of panels are supported, each with its own clock line, sharing
+  // the data lines. bytesToSend is the total for each row across all the blocks
+  void Initialise(byte *frameBuffers, uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, uint8_t blocks = 1, const MBI5034PinMap *pins = 0);
 
-  // Start showing the display
-  static void StartDisplay();
+  // Translate count frame buffer bytes into the GPIO words to write for each clock
+  void EncodeOutput(const byte *frameBuffers, uint32_t *frameWords, uint32_t count);
+
+  // What refreshing a configuration costs with the timing set in
+  // ESP32_4xMBI5034_Pins.h, taking the data lines to be GPIO 0-31
+  static constexpr MBI5034RefreshCost GetRefreshCost(uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, uint8_t blocks)
+  {
+    return MBI5034RefreshCost(colourDepth, planes, bytesToSend, REFRESH_INTERVAL_uS,
+                              REFRESH_TICKS_PER_uS, REFRESH_SHIFT_NS_PER_CLOCK, REFRESH_MAX_BIT_WEIGHT);
+  }
 
 private:  
-  static void IRAM_ATTR RefreshInterrupt();
+  friend class ESP32_MBI5034Refresh<ESP32_16xMBI5034>;
+
+  // Clock out one row, from words if given, else translating the frame buffer bytes
+  void IRAM_ATTR ShiftOutRow(const byte *f, const uint32_t *w, uint32_t out);
+
+  // The pins, translated by Initialise for the refresh interrupt
+  uint8_t _blocks = 1;
+  uint32_t _clockBits[4] = {0};  // CLK line for each block
 };
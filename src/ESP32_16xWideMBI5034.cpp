@@ -0,0 +1,150 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class encapsulates the platform-specific driver for refreshing up to 16
+LED display panels using MBI5034 chips, as 4 blocks of 4 panels, with 16 data
+lines so that 2 blocks are shifted out at once.
+******************************************************************************/
+#include "ESP32_16xWideMBI5034.h"
+#include <driver/rtc_io.h>
+
+//////////////////////////////////////////////////////////////////////////
+// The pins used unless others are given to Initialise
+//
+static const MBI5034PinMap DefaultPins =
+{
+  { PIN_D1, PIN_D2, PIN_D3, PIN_D4, PIN_D5, PIN_D6, PIN_D7, PIN_D8,
+    PIN_D9, PIN_D10, PIN_D11, PIN_D12, PIN_D13, PIN_D14, PIN_D15, PIN_D16 }, 16,
+  PIN_A0, PIN_A1, { PIN_CLK_A, PIN_CLK_B }, 2, PIN_LAT, PIN_OE
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+
+void ESP32_16xWideMBI5034::Initialise(byte *frameBuffers, uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, uint8_t blocks, const MBI5034PinMap *pins)
+{
+  _blocks = blocks > 4 ? 4 : blocks;
+  _pairs = (_blocks + 1) / 2;
+
+  // Check the pins before driving any of them
+  if(!pins)
+    pins = &DefaultPins;
+  const char *error = pins->Validate();
+  if(!error && pins->dataLines < 16)
+    error = "16 data lines are needed";
+  if(!error && pins->clocks < _pairs)
+    error = "Not enough clock lines for the blocks";
+  if(!SetupPins(frameBuffers, colourDepth, planes, bytesToSend, pins, error))
+    return;
+
+  // The second block of each pair on D9-D16
+  if(!_gpioMappingSecond)
+  {
+    _gpioMappingSecond = new uint32_t[256];
+    _gpioMappingSecond1 = new uint32_t[256];
+  }
+  pins->BuildMapping(_gpioMappingSecond, _gpioMappingSecond1, 8);
+  for(uint8_t n = 0; n < _pairs; n++)
+    _clockBits[n] = BIT(pins->clk[n]);
+  _clockMask = pins->GetClockBits();
+
+  SetupRefresh((uint32_t)_pairs * (_bytesToSend / _blocks));
+}
+
+ESP32_16xWideMBI5034::~ESP32_16xWideMBI5034()
+{
+  // Stop the refresh before freeing the mappings it uses
+  ESP32_RefreshTimers::Detach(_timer);
+  _timer = 0;
+  delete[] _gpioMappingSecond;
+  delete[] _gpioMappingSecond1;
+}
+
+void ESP32_16xWideMBI5034::EncodeOutput(const byte *frameBuffers, uint32_t *frameWords, uint32_t count)
+{
+  // Same translation the refresh interrupt would otherwise do every time
+  MBI5034ParallelLayout::Encode(frameBuffers, frameWords, count, _bytesToSend, _blocks, 2,
+                                [this](uint8_t lane, byte data) { return lane ? _gpioMappingSecond[data] : _gpioMapping[data]; });
+}
+
+void IRAM_ATTR ESP32_16xWideMBI5034::ShiftOutRow(const byte *f, const uint32_t *w, uint32_t out)
+{
+	// Each pair of blocks in turn, with only its own clock line
+	uint16_t bytesPerBlock = _bytesToSend / _blocks;
+	if (w)
+	{
+		// Already translated, so just write each word out and clock it
+		for (uint8_t pair = 0; pair < _pairs; pair++)
+		{
+			uint32_t clk = _clockBits[pair];
+			for (uint16_t n = 0; n < bytesPerBlock; n++) 
+			{
+				GPIO.out = out | *w++;
+				GPIO.out_w1ts = clk;  
+			}
+		}
+	}
+	else if (_dataBits1)
+	{
+		// Some data lines are above GPIO 31, so write those too
+		uint32_t out1 = GPIO.out1.val & ~_dataBits1;
+		for (uint8_t pair = 0; pair < _pairs; pair++, f += bytesPerBlock)
+		{
+			uint32_t clk = _clockBits[pair];
+			bool second = pair * 2 + 1 < _blocks;
+			for (uint16_t n = 0; n < bytesPerBlock; n++, f++) 
+			{
+				GPIO.out1.val = out1 | _gpioMapping1[f[0]] | (second ? _gpioMappingSecond1[f[bytesPerBlock]] : 0);
+				GPIO.out = out | _gpioMapping[f[0]] | (second ? _gpioMappingSecond[f[bytesPerBlock]] : 0);
+				GPIO.out_w1ts = clk;  
+			}
+		}
+	}
+	else
+	{
+		for (uint8_t pair = 0; pair < _pairs; pair++, f += bytesPerBlock)
+		{
+			uint32_t clk = _clockBits[pair];
+			if (pair * 2 + 1 < _blocks)
+			{
+				// Both blocks at once, one on each half of the data lines
+				for (uint16_t n = 0; n < bytesPerBlock; n++, f++) 
+				{
+					GPIO.out = out | _gpioMapping[f[0]] | _gpioMappingSecond[f[bytesPerBlock]];
+					GPIO.out_w1ts = clk;  
+				}
+			}
+			else
+			{
+				// An odd block at the end on its own
+				for (uint16_t n = 0; n < bytesPerBlock; n++) 
+				{
+					GPIO.out = out | _gpioMapping[*f++];
+					GPIO.out_w1ts = clk;  
+				}
+			}
+		}
+	}
+}
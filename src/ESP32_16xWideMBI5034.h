@@ -0,0 +1,76 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class encapsulates the platform-specific driver for refreshing up to 16
+LED display panels using MBI5034 chips, as 4 blocks of 4 panels, with 16 data
+lines rather than 8.
+
+The first and third blocks use data lines D1-D8 and the second and fourth
+D9-D16, so each pair of blocks can be shifted out at the same time on a shared
+clock line, taking half the time per row of ESP32_16xMBI5034. The frame
+buffers are the same, so it can be swapped in for that driver when the panels
+are wired this way.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "ESP32_MBI5034Refresh.h"
+#include "MBI5034RefreshCost.h"
+#include "MBI5034ParallelLayout.h"
+
+class ESP32_16xWideMBI5034 : public ESP32_MBI5034Refresh<ESP32_16xWideMBI5034>
+{
+public:
+  ~ESP32_16xWideMBI5034();
+
+  // Up to 4 blocks of panels are supported, in pairs sharing a clock line.
+  // bytesToSend is the total for each row across all the blocks
+  void Initialise(byte *frameBuffers, uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, uint8_t blocks = 1, const MBI5034PinMap *pins = 0);
+
+  // Translate count frame buffer bytes, made up of whole rows, into the GPIO words
+  // to write for each clock. Each word carries a byte from each block of a pair,
+  // so only the first half of the words of each row are used.
+  void EncodeOutput(const byte *frameBuffers, uint32_t *frameWords, uint32_t count);
+
+  // What refreshing a configuration costs with the timing set in
+  // ESP32_4xMBI5034_Pins.h, taking the data lines to be GPIO 0-31
+  static constexpr MBI5034RefreshCost GetRefreshCost(uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, uint8_t blocks)
+  {
+    return MBI5034RefreshCost(colourDepth, planes, MBI5034ParallelLayout::GetRowClocks(bytesToSend, blocks, 2), REFRESH_INTERVAL_uS,
+                              REFRESH_TICKS_PER_uS, REFRESH_SHIFT_NS_PER_CLOCK, REFRESH_MAX_BIT_WEIGHT);
+  }
+
+private:  
+  friend class ESP32_MBI5034Refresh<ESP32_16xWideMBI5034>;
+
+  // Clock out one row, from words if given, else translating the frame buffer bytes
+  void IRAM_ATTR ShiftOutRow(const byte *f, const uint32_t *w, uint32_t out);
+
+  // The pins, translated by Initialise for the refresh interrupt
+  uint32_t *_gpioMappingSecond = 0;   // GPIO bits to set for a frame buffer byte on D9-D16, for the second block of each pair
+  uint32_t *_gpioMappingSecond1 = 0;  // The same for data lines above GPIO 31, if there are any
+  uint8_t _blocks = 1;
+  uint8_t _pairs = 1;            // Pairs of blocks, the last may only have one
+  uint32_t _clockBits[2] = {0};  // CLK line for each pair
+};
@@ -29,6 +29,9 @@ panel (i.e. maximum of 8 data lines currently).
 ******************************************************************************/
 #pragma once
 
+// These are the default pins for the drivers, which can be overridden at run
+// time by passing a MBI5034PinMap to the panel's constructor instead.
+//
 // These are for the ESP32-DevKitC board with WROOM chip
 // Only unused GPIO pins 0-31 are usable as the PIN_Dx or PIN_Ax pins
 #define PIN_D1    GPIO_NUM_18  // D1 on Panel 1 (Top)
@@ -55,9 +58,38 @@ panel (i.e. maximum of 8 data lines currently).
 #define PIN_CLK2   GPIO_NUM_26  // CLK on Panels 9-12
 #define PIN_CLK3   GPIO_NUM_27  // CLK on Panels 13-16
 
+// These are for the 16 panel configuration with 16 data lines (ESP32_16xWideMBI5034).
+// Panels 5-8 and 13-16 have their own data lines, so each pair of blocks is clocked
+// out at the same time using one CLK line. The extra data lines must also be on
+// GPIO pins 0-31, and the DevKitC doesn't have enough spare, so these take over
+// CLK1 and CLK3 and use the serial port pins as well, i.e. Serial can't be used.
+#define PIN_D9     GPIO_NUM_12  // D1 on Panel 5 and 13
+#define PIN_D10    GPIO_NUM_13  // D2 on Panel 5 and 13
+#define PIN_D11    GPIO_NUM_14  // D1 on Panel 6 and 14
+#define PIN_D12    GPIO_NUM_23  // D2 on Panel 6 and 14
+#define PIN_D13    GPIO_NUM_25  // D1 on Panel 7 and 15
+#define PIN_D14    GPIO_NUM_27  // D2 on Panel 7 and 15
+#define PIN_D15    GPIO_NUM_1   // D1 on Panel 8 and 16
+#define PIN_D16    GPIO_NUM_3   // D2 on Panel 8 and 16 (Bottom)
+#define PIN_CLK_A  GPIO_NUM_22  // CLK on Panels 1-8
+#define PIN_CLK_B  GPIO_NUM_26  // CLK on Panels 9-16
+
 // All panel refreshes are done through a hardware timer interrupt
 // Change this if it clashes with other usages (0-2)
 #define REFRESH_TIMER_NUMBER	0
 
 // Target total refresh rate in microseconds. 6000uS gives a good flicker-free display at around 150Hz
+// Panels that can't all be shifted out in this time fail to build, see MBI5034RefreshCost.h
 static const uint64_t REFRESH_INTERVAL_uS = 6000;
+
+// Resolution of the refresh timer, which sets how precisely each bit's on-time can be set
+static const uint32_t REFRESH_TICKS_PER_uS = 10;
+
+// Time to shift out one clock's worth of data, i.e. about 39uS for 384 clocks
+static const uint32_t REFRESH_SHIFT_NS_PER_CLOCK = 100;
+
+// Bits weighing more than this (1 for the least significant, doubling for each bit above)
+// are split up and spread over the refresh cycle, so the display is seen to flicker faster,
+// e.g. 4 shows the top bit of a 5-bit colour depth 4 times per cycle. 0 to never split them.
+static const uint8_t REFRESH_MAX_BIT_WEIGHT = 0;
+static_assert( (REFRESH_MAX_BIT_WEIGHT & (REFRESH_MAX_BIT_WEIGHT - 1)) == 0, "REFRESH_MAX_BIT_WEIGHT must be 0 or a power of two" );
@@ -0,0 +1,481 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class is the refresh common to the ESP32 platform drivers, which derive
+from it passing themselves as DRIVER. It owns the timer and the refresh
+interrupt, which works through the schedule one row at a time, switches frames
+and brightness between refresh cycles, dims and skips rows and latches each
+row once it has been shifted out.
+
+Only shifting out a row depends on how the panels are wired, so each driver
+has its own ShiftOutRow, along with checking and setting up its pins.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "MBI5034RefreshStats.h"
+#include "MBI5034Schedule.h"
+#include "MBI5034PinMap.h"
+#include "ESP32_4xMBI5034_Pins.h"
+#include "ESP32_RefreshTimers.h"
+
+template<class DRIVER> class ESP32_MBI5034Refresh
+{
+public:
+  // Each instance refreshes its own set of panels, using its own timer
+  ~ESP32_MBI5034Refresh()
+  {
+    ESP32_RefreshTimers::Detach(_timer);
+    delete[] _gpioMapping;
+    delete[] _gpioMapping1;
+  }
+
+  /*
+   * The Control Port for each chip is a 16-bit value in the following format
+   * 
+   *  01EE00CCCCHDDDDD
+   *  where E=Error detection time (11 default)
+   *        C=Check bits (must be 0101)
+   *        H=High current
+   *        D=Current gain (000000=12.5% to 111111=200%)
+   *  default
+   *    0b0111000101101011 (0x716B) for 100% gain
+   */
+  // Set the current gain of all the chips, from 12% to 200%. Once the display is
+  // running, it is changed between refresh cycles so the display isn't disrupted.
+  void SetBrightness(uint16_t brighnessPercent)
+  {
+    // Two current ranges are selectable:
+    // if H=0, Current = 0.125-0.488
+    // if H=1, Current = 0.508-1.938, where 0b1011=1 (100%)
+    
+    // Calculate the approx brightness control around 100%
+    uint32_t brightness = 0;
+    const uint32_t brightness100pc = 0x2b;
+    if(brighnessPercent <= 12)
+      brightness = 0;
+    else if(brighnessPercent <= 100)
+      brightness = (brighnessPercent - 12) * brightness100pc / 88;
+    else if(brighnessPercent >= 200)
+    {
+      brightness = 63;
+    }
+    else
+      brightness = (brighnessPercent - 100) * (63-brightness100pc) / 100 + 0x2b;
+
+    uint16_t controlRegister = 0b0111000101000000 | brightness;
+    if(_timer && timerAlarmEnabled(_timer))
+    {
+      // Written by the refresh interrupt between frames, so it isn't disrupted
+      _pendingControl = CONTROL_PENDING | controlRegister;
+    }
+    else if(_pinsValid)
+    {
+      WriteControlRegister(controlRegister);
+    }
+  }
+
+  // Dim the display further by only enabling the outputs for part of each on-time,
+  // from 0 (off) to 255 (fully on), taking effect from the next row
+  void SetDimming(uint8_t level)
+  {
+    // 255 is taken as fully on
+    _dimming = level == 255 ? 256 : level;
+  }
+
+  // Start showing the display
+  void StartDisplay()
+  {
+    // Start refresh, unless the pins weren't valid or there wasn't a timer
+    if(!_timer || timerAlarmEnabled(_timer))
+      return;
+
+    // Start part way through the refresh cycle if other displays are already being
+    // refreshed, so their runs of short interrupts for the lower bits don't coincide
+    static const uint8_t phaseQuarters[ESP32_RefreshTimers::MAX_TIMERS] = { 0, 2, 1, 3 };
+    uint8_t others = ESP32_RefreshTimers::GetRunningCount(_timer);
+    _step = _schedule.GetStepAt(_schedule.GetFrameTicks() / 4 * phaseQuarters[others % ESP32_RefreshTimers::MAX_TIMERS]);
+    timerAlarmWrite(_timer, _schedule.GetStepTicks(_step), true);
+    timerAlarmEnable(_timer);
+  }
+
+  // Switch to showing a different frame buffer at the end of the current refresh
+  // cycle, so the display never shows part of one frame and part of another.
+  // If frameWords is given, the refresh writes those out as they are instead,
+  // having been translated from the frame buffer by EncodeOutput. If occupancy
+  // is given, it has a bit for each depth with anything lit for each address
+  // plane, and rows with nothing lit are skipped with the outputs left off.
+  // If dimming is given (0 to 255, as SetDimming) it changes to that at the
+  // same point, e.g. so a power limit worked out for the frame comes with it.
+  void PresentFrame(byte *frameBuffers, uint32_t *frameWords = 0, const uint8_t *occupancy = 0, int16_t dimming = -1)
+  {
+    if(_timer && timerAlarmEnabled(_timer))
+    {
+      // Picked up by the refresh interrupt at the end of the cycle. The words
+      // only cover GPIO.out, so aren't used with data lines above GPIO 31.
+      _pendingFrameWords = _dataBits1 ? 0 : frameWords;
+      _pendingOccupancy = occupancy;
+      _pendingDimming = dimming < 0 ? 0 : DIMMING_PENDING | (dimming >= 255 ? 256 : dimming);
+      _pendingFrameBuffers = frameBuffers;
+    }
+    else
+    {
+      // Not refreshing, so nothing to wait for
+      _frameWords = _dataBits1 ? 0 : frameWords;
+      _occupancy = occupancy;
+      _frameBuffers = frameBuffers;
+      if(dimming >= 0)
+        SetDimming(dimming >= 255 ? 255 : dimming);
+    }
+  }
+
+  // True until the refresh has switched to the frame last presented
+  bool FramePending()
+  {
+    return _pendingFrameBuffers != 0;
+  }
+
+  // Number of whole refresh cycles (all planes at all colour depths) completed
+  uint32_t GetFrameCount()
+  {
+    return _frameCount;
+  }
+
+  // Whole refresh cycles per second, as measured over the last one
+  uint32_t GetRefreshRate()
+  {
+    uint32_t period = _framePeriod_uS;
+    return period ? 1000000 / period : 0;
+  }
+
+#if HHLED_REFRESH_STATS
+  // Timing of the refresh interrupt since the last reset
+  void GetRefreshStats(MBI5034RefreshStats &stats)
+  {
+    portENTER_CRITICAL(&_statsMux);
+    stats = _stats;
+    portEXIT_CRITICAL(&_statsMux);
+    stats.refreshRate = GetRefreshRate();
+  }
+
+  void ResetRefreshStats()
+  {
+    portENTER_CRITICAL(&_statsMux);
+    _stats = MBI5034RefreshStats();
+    portEXIT_CRITICAL(&_statsMux);
+  }
+#endif
+
+  // Wait for a refresh cycle to complete since the last call, for up to timeoutMs.
+  // Returns straight away if one already has, so 0 can be used to poll.
+  // Returns true if a refresh cycle has completed.
+  bool WaitForFrame(uint32_t timeoutMs = UINT32_MAX)
+  {
+    TickType_t ticks = timeoutMs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+
+    while(_frameCount == _lastWaitedFrame && ticks)
+    {
+      // Ask to be notified, checking again in case the cycle has just ended
+      _frameWaiter = xTaskGetCurrentTaskHandle();
+      if(_frameCount != _lastWaitedFrame)
+        break;
+      if(!ulTaskNotifyTake(pdTRUE, ticks))
+        break;
+    }
+    _frameWaiter = 0;
+
+    if(_frameCount == _lastWaitedFrame)
+      return false;
+    _lastWaitedFrame = _frameCount;
+    return true;
+  }
+
+protected:
+  // Take on the frame buffers and set up the pins, unless the driver found an
+  // error with them, in which case nothing is driven and false is returned.
+  // The driver fills in its own clock lines afterwards.
+  bool SetupPins(byte *frameBuffers, uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, const MBI5034PinMap *pins, const char *error)
+  {
+    _frameBuffers = frameBuffers;
+    _frameWords = 0;
+    _occupancy = 0;
+    _colourDepth = colourDepth;
+    _planes = planes;
+    _bytesToSend = bytesToSend;
+
+    _pinsValid = !error;
+    if(error)
+    {
+      log_e("Invalid pin map: %s", error);
+      return false;
+    }
+
+    if(!_gpioMapping)
+    {
+      _gpioMapping = new uint32_t[256];
+      _gpioMapping1 = new uint32_t[256];
+    }
+    pins->BuildMapping(_gpioMapping, _gpioMapping1);
+    _dataBits = pins->GetDataBits();
+    _dataBits1 = pins->GetDataBits1();
+    for(uint8_t bank = 0; bank < 4; bank++)
+      _addressBits[bank] = pins->GetAddressBits(bank);
+    _latchBit = BIT(pins->lat);
+    _enableBit = BIT(pins->oe);
+
+    // Set up GPIO lines
+    uint8_t used[MBI5034PinMap::MAX_PINS];
+    uint8_t count = pins->GetPins(used);
+    for(uint8_t n = 0; n < count; n++)
+    {
+      gpio_pad_select_gpio((gpio_num_t)used[n]);
+      gpio_set_direction((gpio_num_t)used[n], GPIO_MODE_OUTPUT);
+    }
+
+    gpio_set_level((gpio_num_t)pins->oe, 1);
+    gpio_set_level((gpio_num_t)pins->lat, 0);
+    for(uint8_t n = 0; n < pins->clocks; n++)
+      gpio_set_level((gpio_num_t)pins->clk[n], 0);
+    return true;
+  }
+
+  // Create the interrupts to refresh the panels, for rows taking rowClocks
+  // clocks to shift out. The interrupt then re-arms the timer for each bit's
+  // on-time after enabling the outputs
+  void SetupRefresh(uint32_t rowClocks)
+  {
+    _schedule.Compute(_colourDepth, _planes, REFRESH_INTERVAL_uS * REFRESH_TICKS_PER_uS,
+                      rowClocks * REFRESH_SHIFT_NS_PER_CLOCK * REFRESH_TICKS_PER_uS / 1000,
+                      REFRESH_MAX_BIT_WEIGHT);
+#if HHLED_REFRESH_STATS
+    _budgetCycles = rowClocks * REFRESH_SHIFT_NS_PER_CLOCK * getCpuFrequencyMhz() / 1000;
+#endif
+    if(!_timer)
+      _timer = ESP32_RefreshTimers::Attach(&RefreshInterrupt, this, REFRESH_TIMER_NUMBER, 80 / REFRESH_TICKS_PER_uS);  // 80 for Microseconds
+    if(!_timer)
+    {
+      log_e("No timer free to refresh the display");
+      return;
+    }
+    timerAlarmWrite(_timer, _schedule.GetStepTicks(0), true);
+  }
+
+  hw_timer_t *_timer = 0;
+  byte *_frameBuffers = 0;    // Array of [depth][bank][leds]
+  byte * volatile _pendingFrameBuffers = 0;  // Next frame to show, when the refresh cycle ends
+  uint32_t *_frameWords = 0;  // Pre-translated GPIO words for _frameBuffers, if any
+  uint32_t * volatile _pendingFrameWords = 0;
+  const uint8_t *_occupancy = 0;  // Depths with anything lit for each bank, if known
+  const uint8_t * volatile _pendingOccupancy = 0;
+  volatile uint32_t _frameCount = 0;
+  uint32_t _lastWaitedFrame = 0;
+  volatile TaskHandle_t _frameWaiter = 0;   // Task to notify when the refresh cycle ends
+  uint8_t _colourDepth = 0;
+  uint8_t _planes = 0;
+  uint16_t _bytesToSend = 0;
+  MBI5034Schedule _schedule;  // On-time of each bit
+  uint16_t _step = 0;         // Row of the schedule being shown
+  bool _dimmed = false;       // Outputs turned off early, waiting out the rest of the on-time
+  uint32_t _frameStart_uS = 0;
+  volatile uint32_t _framePeriod_uS = 0;  // Time the last whole refresh cycle took
+  volatile uint32_t _pendingControl = 0;  // Control register to write at the end of the refresh cycle, if CONTROL_PENDING set
+  volatile uint16_t _dimming = 256;       // Fraction of each on-time the outputs are enabled for, out of 256
+  volatile uint16_t _pendingDimming = 0;  // Dimming to switch to with the next frame, if DIMMING_PENDING set
+  uint32_t _dimmedTicks = 0;  // Part of the current on-time the outputs are enabled for
+#if HHLED_REFRESH_STATS
+  MBI5034RefreshStats _stats;
+  uint32_t _budgetCycles = 0; // Time allowed for each interrupt, as assumed by the schedule
+  portMUX_TYPE _statsMux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+  // The pins, translated by SetupPins and the driver for the refresh interrupt
+  bool _pinsValid = false;
+  uint32_t *_gpioMapping = 0;    // GPIO bits to set for each value of a frame buffer byte
+  uint32_t *_gpioMapping1 = 0;   // The same for data lines above GPIO 31, if there are any
+  uint32_t _dataBits = 0;
+  uint32_t _dataBits1 = 0;
+  uint32_t _addressBits[4] = {0};
+  uint32_t _clockMask = 0;       // All the clock lines driven
+  uint32_t _latchBit = 0;
+  uint32_t _enableBit = 0;
+
+private:
+  static const uint32_t CONTROL_PENDING = 0x10000;  // Set in _pendingControl when there is one to write
+  static const uint16_t DIMMING_PENDING = 0x8000;   // Set in _pendingDimming when there is one to switch to
+
+  static void IRAM_ATTR RefreshInterrupt(void *driver)
+  {
+    ESP32_MBI5034Refresh *display = (ESP32_MBI5034Refresh *)driver;
+#if HHLED_REFRESH_STATS
+    uint32_t start = ESP.getCycleCount();
+    bool shifted = display->RefreshRow();
+    uint32_t end = ESP.getCycleCount();
+
+    // Only shifting out a row is given a time by the schedule, so can overrun
+    portENTER_CRITICAL_ISR(&display->_statsMux);
+    display->_stats.Record(start, end, shifted ? display->_budgetCycles : UINT32_MAX);
+    portEXIT_CRITICAL_ISR(&display->_statsMux);
+#else
+    display->RefreshRow();
+#endif
+  }
+
+  // Show the next row of the schedule
+  // True if it shifted out a row, the only interrupts the schedule allows a time for
+  bool IRAM_ATTR RefreshRow()
+  {
+    // Called when the on-time of the bit currently being displayed has expired
+    GPIO.out_w1ts = _enableBit;       // disable output
+
+    // Or part way through it when dimmed, so wait for the rest of it
+    if (_dimmed)
+    {
+      _dimmed = false;
+      timerAlarmWrite(_timer, _schedule.GetStepTicks(_step) - _dimmedTicks, true);
+      timerRestart(_timer);
+      return false;
+    }
+
+    // Next row of the schedule
+    bool cycleEnded = false;
+    if (++_step >= _schedule.GetStepCount()) 
+    {
+      _step = 0;
+      cycleEnded = true;
+
+      // Whole refresh cycle done, so safe to change the brightness
+      if(_pendingControl & CONTROL_PENDING)
+      {
+        WriteControlRegister(_pendingControl);
+        _pendingControl = 0;
+      }
+
+      // and switch to any new frame
+      if(_pendingFrameBuffers)
+      {
+        _frameWords = _pendingFrameWords;
+        _occupancy = _pendingOccupancy;
+        _frameBuffers = _pendingFrameBuffers;
+        if(_pendingDimming & DIMMING_PENDING)
+          _dimming = _pendingDimming & ~DIMMING_PENDING;
+        _pendingFrameBuffers = 0;
+      }
+
+      // Let anyone waiting know
+      uint32_t now = micros();
+      _framePeriod_uS = now - _frameStart_uS;
+      _frameStart_uS = now;
+      _frameCount++;
+      if(_frameWaiter)
+      {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(_frameWaiter, &woken);
+        _frameWaiter = 0;
+        if(woken)
+          portYIELD_FROM_ISR();
+      }
+    }
+
+    uint8_t bank = _schedule.GetStep(_step).bank;
+    uint8_t depth = _schedule.GetStep(_step).depth;   // 0 = for top bit
+
+    // Nothing lit on this row, so leave the outputs off rather than shift it out
+    if (_occupancy && !(_occupancy[bank] & (1 << depth)))
+    {
+      timerAlarmWrite(_timer, _schedule.GetStepTicks(_step), true);
+      timerRestart(_timer);
+      return false;
+    }
+
+    // Get the current port state, so we don't change unrelated lines
+    uint32_t out = GPIO.out
+                  & ~(_dataBits | _addressBits[3] | _latchBit | _clockMask)   // address 3 has both lines set
+                  | _enableBit; 
+
+    // Shifted out as the driver's panels are wired, from the words if there are any
+    uint32_t offset = (bank + depth*_planes)*_bytesToSend;
+    static_cast<DRIVER *>(this)->ShiftOutRow(_frameBuffers + offset, _frameWords ? _frameWords + offset : 0, out);
+    GPIO.out_w1tc = _clockMask;
+
+    GPIO.out = out | _addressBits[bank]; // Set address
+    GPIO.out_w1ts = _latchBit;   // toggle latch
+    GPIO.out_w1tc = _latchBit; 
+
+    // Show this row for exactly the on-time of its step, however long it took to shift out,
+    // or just the dimmed part of it
+    // A row dimmed to less than a tick is left dark for its whole step, rather than being
+    // shown at full on-time, so dimming stays monotonic on the short low bits
+    uint32_t ticks = _schedule.GetStepTicks(_step);
+    uint16_t dimming = _dimming;
+    bool enable = true;
+    if (dimming < 256)
+    {
+      _dimmedTicks = ticks * dimming >> 8;
+      _dimmed = _dimmedTicks != 0;
+      enable = _dimmed;
+      if (_dimmed)
+        ticks = _dimmedTicks;
+    }
+    timerAlarmWrite(_timer, ticks, true);
+    if (enable)
+      GPIO.out_w1tc = _enableBit;     // enable output
+    timerRestart(_timer);
+
+    // Changing the brightness and frame at the end of a cycle takes longer
+    return !cycleEnded;
+  }
+
+  // Send the control register to each of the chips, on each address plane
+  void IRAM_ATTR WriteControlRegister(uint16_t control)
+  {
+    // Get the current port state, so we don't change unrelated lines
+    uint32_t all_D_bits = _dataBits;
+    uint32_t out = GPIO.out & ~all_D_bits & ~(_addressBits[3] | _latchBit | _clockMask | _enableBit); 
+    uint32_t out1 = GPIO.out1.val & ~_dataBits1;
+    
+    for(int bank = 0; bank < 4; bank++)
+    {
+      uint32_t addr = _addressBits[bank];
+      
+      // Need to send the brightness command to each of the chips
+      GPIO.out = addr | out | _enableBit;  // Set address
+      for(int chip = 0; chip < 24; chip++)
+      {
+        //GPIO.out_w1ts = BIT(PIN_LAT); // Assert LAT, so chip recoginises as a control write
+        uint16_t controlRegister = control;
+        for (uint16_t n = 0; n < 16; n++, controlRegister <<= 1) 
+        {
+          if (_dataBits1)
+            GPIO.out1.val = out1 | ((controlRegister & 0x8000) ? _dataBits1 : 0);
+          GPIO.out = ((controlRegister & 0x8000) ? all_D_bits : 0)
+                      | (n < 12 || chip != 23 ? 0 : _latchBit) 
+                      | addr | out | _enableBit;
+          GPIO.out_w1ts = _clockMask;
+        }
+        GPIO.out_w1tc = _clockMask;
+      }
+      GPIO.out_w1tc = _latchBit; // Write control
+    }
+  }
+};
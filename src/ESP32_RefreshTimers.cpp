@@ -0,0 +1,81 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class shares out the ESP32's 4 hardware timers between the refresh
+interrupts of the display driver instances.
+******************************************************************************/
+#include "ESP32_RefreshTimers.h"
+
+// Statics, kept in RAM for the interrupts
+static hw_timer_t *_timers[ESP32_RefreshTimers::MAX_TIMERS];
+static ESP32_RefreshTimers::Handler _handlers[ESP32_RefreshTimers::MAX_TIMERS];
+static void *_drivers[ESP32_RefreshTimers::MAX_TIMERS];
+
+template<uint8_t N> void IRAM_ATTR ESP32_RefreshTimers::Interrupt()
+{
+  _handlers[N](_drivers[N]);
+}
+
+hw_timer_t *ESP32_RefreshTimers::Attach(Handler handler, void *driver, uint8_t firstTimer, uint16_t divider)
+{
+  static void (* const interrupts[MAX_TIMERS])() = { &Interrupt<0>, &Interrupt<1>, &Interrupt<2>, &Interrupt<3> };
+
+  for(uint8_t n = 0; n < MAX_TIMERS; n++)
+  {
+    uint8_t timer = (firstTimer + n) % MAX_TIMERS;
+    if(_timers[timer])
+      continue;
+
+    _handlers[timer] = handler;
+    _drivers[timer] = driver;
+    _timers[timer] = timerBegin(timer, divider, true);
+    timerAttachInterrupt(_timers[timer], interrupts[timer], true);
+    return _timers[timer];
+  }
+  return 0;
+}
+
+void ESP32_RefreshTimers::Detach(hw_timer_t *timer)
+{
+  for(uint8_t n = 0; n < MAX_TIMERS; n++)
+  {
+    if(_timers[n] != timer || !timer)
+      continue;
+
+    timerAlarmDisable(timer);
+    timerDetachInterrupt(timer);
+    timerEnd(timer);
+    _timers[n] = 0;
+  }
+}
+
+uint8_t ESP32_RefreshTimers::GetRunningCount(hw_timer_t *except)
+{
+  uint8_t count = 0;
+  for(uint8_t n = 0; n < MAX_TIMERS; n++)
+    if(_timers[n] && _timers[n] != except && timerAlarmEnabled(_timers[n]))
+      count++;
+  return count;
+}
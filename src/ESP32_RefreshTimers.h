@@ -0,0 +1,55 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class shares out the ESP32's 4 hardware timers between the refresh
+interrupts of the display driver instances, so more than one set of panels can
+be refreshed from one controller, each set on its own pins.
+
+Timer interrupt handlers don't take any arguments, so each timer has its own
+handler here passing the interrupt on to the driver attached to it.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+
+class ESP32_RefreshTimers
+{
+public:
+  static const uint8_t MAX_TIMERS = 4;
+
+  typedef void (*Handler)(void *driver);
+
+  // Attach the refresh interrupt of a driver to the first free timer from
+  // firstTimer, counting at 80MHz / divider. Returns 0 if they're all in use.
+  static hw_timer_t *Attach(Handler handler, void *driver, uint8_t firstTimer, uint16_t divider);
+
+  // Stop a timer and free it up again
+  static void Detach(hw_timer_t *timer);
+
+  // Number of timers refreshing displays, other than the one given
+  static uint8_t GetRunningCount(hw_timer_t *except);
+
+private:
+  template<uint8_t N> static void IRAM_ATTR Interrupt();
+};
@@ -30,18 +30,26 @@ panels in the same way as other Adafruit LCD and OLED display panels.
 #pragma once
 //#include <Adafruit_GFX.h>
 #include <Arduino_GFX.h>
+#include "MBI5034PinMap.h"
 
 template<class PANELTYPE, class BASECLASS = Arduino_GFX> class HHLedPanel : public BASECLASS
 {
   private:
     PANELTYPE _panel_impl;
-	uint16_t block_x, block_y, block_w, block_h;
+	uint16_t block_x = 0, block_y = 0, block_w = 0, block_h = 0;
+	uint16_t cursor_x = 0, cursor_y = 0;
+
+    // Pixel writer for the rotation currently in effect, selected by setRotation
+    typedef void (HHLedPanel::*PixelWriter)(int16_t x, int16_t y, uint16_t color);
+    PixelWriter _writePixel = &HHLedPanel::writeRotatedPixel<0>;
     
   public: 
-    HHLedPanel(uint16_t maxBrightnessPercent = 12) : BASECLASS(_panel_impl.getWidth(), _panel_impl.getHeight())
+    // The panels are wired to the driver's default pins, unless others are given
+    // to pick at run time, e.g. for different revisions of the controller board
+    HHLedPanel(uint16_t maxBrightnessPercent = 12, const MBI5034PinMap *pins = 0) : BASECLASS(_panel_impl.getWidth(), _panel_impl.getHeight())
     {
 		// Setup the hardware
-      _panel_impl.initialise(maxBrightnessPercent);
+      _panel_impl.initialise(maxBrightnessPercent, pins);
     }
     
 	// These are for compatibility with the Adafruit_SPITFT interface
@@ -57,15 +65,29 @@ template<class PANELTYPE, class BASECLASS = Arduino_GFX> class HHLedPanel : publ
 		block_y = y;
 		block_w = w;
 		block_h = h;
+		cursor_x = x;
+		cursor_y = y;
 	}
 	
 	void writePixels(uint16_t *colors, uint32_t len, bool block,
                                   bool bigEndian)
 	{
-		// Bit simplistic, but will do for now
-		for(uint16_t pixel = 0; pixel < len; pixel++)
+		// Stream the pixels into the window a row segment at a time, carrying
+		// on from where any previous call left off
+		while(len && cursor_y < block_y + block_h)
 		{
-			drawPixel(pixel % block_w + block_x, pixel / block_w + block_y, colors[pixel]);
+			uint32_t run = block_x + block_w - cursor_x;
+			if(run > len)
+				run = len;
+			writeRowSegment(cursor_x, cursor_y, colors, run, bigEndian);
+			colors += run;
+			len -= run;
+			cursor_x += run;
+			if(cursor_x >= block_x + block_w)
+			{
+				cursor_x = block_x;
+				cursor_y++;
+			}
 		}
 	}
 	
@@ -77,7 +99,7 @@ template<class PANELTYPE, class BASECLASS = Arduino_GFX> class HHLedPanel : publ
 	
 	void writePixelPreclipped(int16_t x, int16_t y, uint16_t color)
 	{
-		drawPixel(x,y,color);
+		(this->*_writePixel)(x, y, color);
 	}
 	
 	void drawIndexedBitmap(int16_t x, int16_t y, uint8_t *bitmap, uint16_t *color_index, int16_t w, int16_t h)
@@ -99,33 +121,143 @@ template<class PANELTYPE, class BASECLASS = Arduino_GFX> class HHLedPanel : publ
 	// These are common between the supported interfaces
     void drawPixel(int16_t x, int16_t y, uint16_t color) 
     {
-		// Apply any rotation in effect
-		switch (BASECLASS::getRotation()) {
-		case 1:
-			_panel_impl.drawPixel(_panel_impl.getWidth() - 1 - y, x, color);
-			break;
-		case 2:
-			_panel_impl.drawPixel(_panel_impl.getWidth() - 1 - x, _panel_impl.getHeight() - 1 - y, color);
-			break;
-		case 3:
-			_panel_impl.drawPixel(y, _panel_impl.getHeight() - 1 - x, color);
-			break;
-		 default:
-			_panel_impl.drawPixel(x, y, color);
-			break;
-		}
+      // Clip to the rotated screen, then no further checks are needed
+      if(x < 0 || x >= BASECLASS::width() || y < 0 || y >= BASECLASS::height())
+        return;
+      (this->*_writePixel)(x, y, color);
+    }
+
+    void setRotation(uint8_t r)
+    {
+      BASECLASS::setRotation(r);
+
+      // Select the writer for this rotation once, rather than on every pixel
+      switch (BASECLASS::getRotation()) {
+      case 1:
+        _writePixel = &HHLedPanel::writeRotatedPixel<1>;
+        break;
+      case 2:
+        _writePixel = &HHLedPanel::writeRotatedPixel<2>;
+        break;
+      case 3:
+        _writePixel = &HHLedPanel::writeRotatedPixel<3>;
+        break;
+      default:
+        _writePixel = &HHLedPanel::writeRotatedPixel<0>;
+        break;
+      }
+    }
+
+    // Spans and rectangles are passed to the panel as a whole, so the colour is
+    // only encoded once per call rather than once per pixel
+    void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+    {
+      fillPanelRect(x, y, w, 1, color);
+    }
+
+    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+    {
+      fillPanelRect(x, y, 1, h, color);
+    }
+
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+      fillPanelRect(x, y, w, h, color);
+    }
+
+    void writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+      fillPanelRect(x, y, w, h, color);
+    }
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+    {
+      fillPanelRect(x, y, w, 1, color);
+    }
+
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+    {
+      fillPanelRect(x, y, 1, h, color);
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+      fillPanelRect(x, y, w, h, color);
     }
 
     void fillScreen(uint16_t color)
     {
+      // Black and white set every bit of every plane as they always have,
+      // rather than going through the gamma table like other colours
       if(color == 0)
         _panel_impl.Clear();
       else if(color == 0xffff)
         _panel_impl.Clear(true);
       else
-        BASECLASS::fillScreen(color);
+        _panel_impl.Fill(color);
     }
     
+    // Colour of a pixel, only available when the panel keeps a shadow copy
+    uint16_t readPixel(int16_t x, int16_t y)
+    {
+      switch (BASECLASS::getRotation()) {
+      case 1:
+        return _panel_impl.readPixel(_panel_impl.getWidth() - 1 - y, x);
+      case 2:
+        return _panel_impl.readPixel(_panel_impl.getWidth() - 1 - x, _panel_impl.getHeight() - 1 - y);
+      case 3:
+        return _panel_impl.readPixel(y, _panel_impl.getHeight() - 1 - x);
+      default:
+        return _panel_impl.readPixel(x, y);
+      }
+    }
+
+    // Encode everything drawn since the last call, when the panel keeps a shadow copy
+    void commit()
+    {
+      _panel_impl.commit();
+    }
+
+    // Show everything drawn since the last call, when the panel is double buffered
+    void present(bool copyFrame = true)
+    {
+      _panel_impl.present(copyFrame);
+    }
+
+    // Change the brightness while the display is running, without blanking it.
+    // The current gain of the chips is set from 12% to 200%, and can then be
+    // dimmed further in 256 steps by shortening the time the LEDs are on.
+    void setBrightness(uint16_t brightnessPercent)
+    {
+      _panel_impl.setBrightness(brightnessPercent);
+    }
+
+    void setDimming(uint8_t level)
+    {
+      _panel_impl.setDimming(level);
+    }
+
+    // The platform driver refreshing the panels, e.g. to wait for a refresh cycle
+    auto getPlatform() -> decltype(_panel_impl.getPlatform())
+    {
+      return _panel_impl.getPlatform();
+    }
+
+    // The power governor, when the panel has the HHLED_POWER_LIMIT option, e.g.
+    // to set a current budget or read the estimated current
+    auto getPowerGovernor() -> decltype(_panel_impl.getPowerGovernor())
+    {
+      return _panel_impl.getPowerGovernor();
+    }
+
+    // Levels a pixel is lit at, 0 to 2^COLOUR_DEPTH - 1 for each of red, green
+    // and blue, in panel coordinates regardless of the rotation, read back from
+    // the frame being drawn on or any frame buffers given
+    void decodePixel(int16_t x, int16_t y, uint8_t levels[3], const byte *frame = 0) const
+    {
+      _panel_impl.decodePixel(x, y, levels, frame);
+    }
+
     void clear()
     {
 	  BASECLASS::setCursor(0,0);
@@ -138,4 +270,81 @@ template<class PANELTYPE, class BASECLASS = Arduino_GFX> class HHLedPanel : publ
       return (((blue) >> 3) | ((green) >> 2 << 5) | ((red) >> 3 << 11));
     }
 
+  private:
+    // Apply the rotation to an already clipped pixel, resolved at compile time
+    template<uint8_t ROTATION> void writeRotatedPixel(int16_t x, int16_t y, uint16_t color)
+    {
+      if(ROTATION == 1)
+        _panel_impl.drawPixelPreclipped(_panel_impl.getWidth() - 1 - y, x, color);
+      else if(ROTATION == 2)
+        _panel_impl.drawPixelPreclipped(_panel_impl.getWidth() - 1 - x, _panel_impl.getHeight() - 1 - y, color);
+      else if(ROTATION == 3)
+        _panel_impl.drawPixelPreclipped(y, _panel_impl.getHeight() - 1 - x, color);
+      else
+        _panel_impl.drawPixelPreclipped(x, y, color);
+    }
+
+    // Draw a run of pixels along a screen row, applying any rotation in effect
+    void writeRowSegment(int16_t x, int16_t y, const uint16_t *colors, int16_t n, bool bigEndian)
+    {
+      switch (BASECLASS::getRotation()) {
+      case 0:
+        _panel_impl.encodeRow(y, x, colors, n, bigEndian);
+        break;
+      case 1:
+        // Screen rows run down the panel columns
+        _panel_impl.encodeColumn(_panel_impl.getWidth() - 1 - y, x, colors, n, bigEndian);
+        break;
+      default:
+        // Screen rows run backwards along the panel rows (2) or up the panel
+        // columns (3), so each chunk of pixels is reversed into panel order first
+        uint16_t reversed[64];
+        while(n > 0)
+        {
+          int16_t chunk = n < 64 ? n : 64;
+          for(int16_t i = 0; i < chunk; i++)
+            reversed[i] = colors[chunk - 1 - i];
+          if(BASECLASS::getRotation() == 2)
+            _panel_impl.encodeRow(_panel_impl.getHeight() - 1 - y, _panel_impl.getWidth() - x - chunk, reversed, chunk, bigEndian);
+          else
+            _panel_impl.encodeColumn(y, _panel_impl.getHeight() - x - chunk, reversed, chunk, bigEndian);
+          colors += chunk;
+          x += chunk;
+          n -= chunk;
+        }
+        break;
+      }
+    }
+
+    // Apply any rotation in effect to a rectangle and fill it on the panel
+    void fillPanelRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+      // Allow for negative sizes, as the GFX libraries do
+      if(w < 0)
+      {
+        x += w + 1;
+        w = -w;
+      }
+      if(h < 0)
+      {
+        y += h + 1;
+        h = -h;
+      }
+
+      switch (BASECLASS::getRotation()) {
+      case 1:
+        _panel_impl.fillRect(_panel_impl.getWidth() - y - h, x, h, w, color);
+        break;
+      case 2:
+        _panel_impl.fillRect(_panel_impl.getWidth() - x - w, _panel_impl.getHeight() - y - h, w, h, color);
+        break;
+      case 3:
+        _panel_impl.fillRect(y, _panel_impl.getHeight() - x - w, h, w, color);
+        break;
+      default:
+        _panel_impl.fillRect(x, y, w, h, color);
+        break;
+      }
+    }
+
 };
@@ -23,126 +23,27 @@ SOFTWARE.
 ******************************************************************************/
 
 /******************************************************************************
-This class is the panel-specific implementation to support drawing and refreshing
+This is the panel-specific implementation to support drawing and refreshing
 Hitchin Hackspce LED display panels arranged as a 64x256 matrix. This is constructed 
 as 16 panels of 64x16 LEDs aranged vertically and driven in parallel by the 
 platform driver.
+
+Fewer panels can be fitted by giving the height in pixels, e.g. 192 for 12
+panels as HHLedPanel_16x64x16_impl<ESP32_16xMBI5034, COLOUR_DEPTH, 0, 192>,
+which only refreshes as many blocks of 4 panels as are needed. It defaults to
+240, as the bottom panel isn't normally fitted.
 ******************************************************************************/
 #pragma once
-#include <Arduino.h>
-#include "hhledpanel-gamma.h"
-
-// Limit max resolution, if not exactly 16 panels required
-#define MAX_HEIGHT_PIXELS 240
-
-template<class PLATFORMTYPE, unsigned short COLOUR_DEPTH> class HHLedPanel_16x64x16_impl
-{
-  static_assert( COLOUR_DEPTH > 0 && COLOUR_DEPTH <= 6, "Maximum colour depth supported is 6" );
-
-private:
-  static const uint16_t CHIPS_PER_DATA_LINE = 24;
-  static const uint16_t LEDS_PER_CHIP = 16;
-  static const uint16_t ADDRESS_PLANES = 4;
-  static const uint16_t TOTAL_BLOCKS = 4;	// Each block being 4 panels
-  
-  byte frameBuffers[COLOUR_DEPTH][ADDRESS_PLANES][CHIPS_PER_DATA_LINE * LEDS_PER_CHIP * TOTAL_BLOCKS];  // [bit][plane][chip]
-  
-public:
-  HHLedPanel_16x64x16_impl()
-  {
-  }
-  
-  void initialise(uint16_t maxBrightnessPercent)
-  {
-	// Setup the hardware
-	PLATFORMTYPE::Initialise(frameBuffers[0][0], COLOUR_DEPTH, ADDRESS_PLANES, CHIPS_PER_DATA_LINE * LEDS_PER_CHIP * TOTAL_BLOCKS);
-	
-	// Clear the screen
-	FillBuffer(0);
-	
-	// Set the base brightness
-	PLATFORMTYPE::SetBrightness(maxBrightnessPercent);
-  }
-  
-  void begin()
-  {
-	// Start refrshing the screen
-	PLATFORMTYPE::StartDisplay();
-  }
-
-  // Dimension of the total panel
-  inline uint32_t getWidth() const
-  {
-	return 64;
-  }
-
-  inline uint32_t getHeight() const
-  {
-    return MAX_HEIGHT_PIXELS;
-  }
-
-  void drawPixel(int16_t x, int16_t y, uint16_t col) 
-	{
-    // Clip to panel
-    if(x < 0 || x >= getWidth() || y < 0 || y >= getHeight())
-      return;
-  
-    // Split the colour into RGB parts and gamma-correct the result
-    uint8_t red = gamma6[(col >> 10) & 0x3e];
-    uint8_t green = gamma6[(col >> 5) & 0x3f];
-    uint8_t blue = gamma6[(col << 1) & 0x3e];
-   
-	int16_t off = (x & 7) + (x & 0x38)*6 + (y & 4)*2 + (y & 0xc0)*6;
-	byte row = y & 3;
-	byte b = (1 << ((y & 0x3f) >> 3));
-   
-    for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
-    {
-  	  byte *p = & frameBuffers[depth][row][off];
-      // Blue LED
-      if ( blue & (0x80 >> depth) ) 
-      {
-        *p |= b;
-      } 
-      else 
-      {
-        *p &= ~b;
-      }
-      p += LEDS_PER_CHIP;
-  
-      // Green LED
-      if ( green & (0x80 >> depth) ) 
-      {
-        *p |= b;
-      } 
-      else 
-      {
-        *p &= ~b;
-      }
-      p += LEDS_PER_CHIP;
-      
-      // Red LED
-      if ( red & (0x80 >> depth) ) 
-      {
-        *p |= b;
-      } 
-      else 
-      {
-        *p &= ~b;
-      }
-      p += LEDS_PER_CHIP;
-     }
-	}
-
-  void Clear(bool toWhite = false)
-  {
-    FillBuffer(toWhite ? 0xff : 0);
-  }
-
-private:
-  void FillBuffer(byte b = 0)
-	{
-      // Quick clear to solid colour (normally black or white)
-      memset(frameBuffers[0][0], b, sizeof(frameBuffers));
-	}	
-};
+#include "HHLedPanel_Chain_impl.h"
+
+// MAX_HEIGHT_PIXELS used to set the height for every 16 panel display in a
+// sketch. It is still used as the default if defined, but is deprecated
+#ifdef MAX_HEIGHT_PIXELS
+#warning "MAX_HEIGHT_PIXELS is deprecated, give the height as the last template argument of HHLedPanel_16x64x16_impl instead"
+#define HHLED_16X_DEFAULT_HEIGHT MAX_HEIGHT_PIXELS
+#else
+#define HHLED_16X_DEFAULT_HEIGHT 240
+#endif
+
+template<class PLATFORMTYPE, unsigned short COLOUR_DEPTH, uint8_t OPTIONS = 0, uint16_t HEIGHT = HHLED_16X_DEFAULT_HEIGHT>
+using HHLedPanel_16x64x16_impl = HHLedPanel_Chain_impl<PLATFORMTYPE, 4, (HEIGHT + 63) / 64, HEIGHT, COLOUR_DEPTH, OPTIONS>;
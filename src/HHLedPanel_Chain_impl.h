@@ -0,0 +1,779 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class is the panel-specific implementation to support drawing and refreshing
+Hitchin Hackspce LED display panels of 64x16 LEDs arranged vertically as one or
+more blocks of up to 4 panels. The panels in a block are driven in parallel by
+the platform driver, 2 data lines per panel, and each block has its own clock.
+
+The geometry is fixed at compile time:
+  PANELS_PER_BLOCK - panels sharing the data lines in each block (1-4)
+  BLOCKS           - number of blocks in the chain
+  ACTIVE_HEIGHT    - rows actually in use, i.e. up to 16 rows per panel
+and the frame buffer is sized to suit, so a chain of 8 or 12 panels only pays
+for the memory and clock-out time of the panels it has.
+
+With HHLED_ENCODED_OUTPUT, the refresh is given a second copy of the frame with
+each byte already translated by the platform into the 32-bit GPIO word to write
+for that clock, so the refresh interrupt does no table lookups at all. This
+costs 4 bytes per clock rather than 1, and changes are only translated, one
+address plane at a time, when commit() or present() is called.
+
+Which bit planes of each address plane have anything lit is kept up as they
+are drawn on, so the refresh can leave the outputs off rather than shift out
+rows that are all zero. Drawing only ever marks planes as lit, so clearing
+parts of the display leaves them marked until commit() or present() checks
+the planes changed since, or the whole display is filled.
+
+With HHLED_POWER_LIMIT, commit() and present() also count the LEDs lit on each
+colour of each bit plane of the address planes changed, to estimate the
+current the frame will draw, and the display is turned down as needed to keep
+within the budget set on getPowerGovernor() (see HHLedPowerGovernor.h). When
+double buffered this is left until present(), and the dimming worked out is
+handed to the platform with the frame, so the two switch over together. The
+estimate is only made there, not as each pixel is drawn, so a sketch using
+this has to call commit() or present() after drawing each frame, even single
+buffered; anything drawn since is shown unlimited until it does.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "hhledpanel-gamma.h"
+#include "MBI5034PinMap.h"
+#include "MBI5034RefreshCost.h"
+#include "HHLedPowerGovernor.h"
+
+// Optional features, combined to make the OPTIONS template parameter
+enum HHLedPanelOptions : uint8_t
+{
+  HHLED_DOUBLE_BUFFER = 1,    // Draw to a back buffer, only shown when present() is called
+  HHLED_ENCODED_OUTPUT = 2,   // Keep the frame as ready-to-write GPIO words, updated by commit()
+  HHLED_POWER_LIMIT = 4,      // Estimate the current of each frame, and turn the display down to keep within a budget,
+                              // only when commit() or present() is called after drawing it
+};
+
+// Limit on the frame buffer memory for a display, override if needed
+#ifndef HHLED_MAX_FRAME_BUFFER_BYTES
+#define HHLED_MAX_FRAME_BUFFER_BYTES (160 * 1024)
+#endif
+
+template<class PLATFORMTYPE, uint8_t PANELS_PER_BLOCK, uint8_t BLOCKS, uint16_t ACTIVE_HEIGHT, unsigned short COLOUR_DEPTH, uint8_t OPTIONS = 0>
+class HHLedPanel_Chain_impl
+{
+  static_assert( COLOUR_DEPTH > 0 && COLOUR_DEPTH <= 6, "Maximum colour depth supported is 6" );
+  static_assert( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Chip groups are encoded as little-endian 64-bit words" );
+  static_assert( PANELS_PER_BLOCK > 0 && PANELS_PER_BLOCK <= 4, "Between 1 and 4 panels per block are supported" );
+  static_assert( ACTIVE_HEIGHT > (BLOCKS - 1) * PANELS_PER_BLOCK * 16 && ACTIVE_HEIGHT <= BLOCKS * PANELS_PER_BLOCK * 16,
+                 "ACTIVE_HEIGHT must use all of the blocks and fit within them" );
+
+private:
+  static const uint16_t CHIPS_PER_DATA_LINE = 24;
+  static const uint16_t LEDS_PER_CHIP = 16;
+  static const uint16_t ADDRESS_PLANES = 4;
+  static const uint16_t BYTES_PER_BLOCK = CHIPS_PER_DATA_LINE * LEDS_PER_CHIP;
+  static const uint16_t LINES_PER_BLOCK = PANELS_PER_BLOCK * 2;   // 8 rows on each data line
+  static const uint16_t BLOCK_HEIGHT = LINES_PER_BLOCK * 8;
+  static const uint8_t FRAME_BUFFERS = (OPTIONS & HHLED_DOUBLE_BUFFER) ? 2 : 1;
+  static const bool ENCODED = (OPTIONS & HHLED_ENCODED_OUTPUT) != 0;
+  static const bool POWER_LIMIT = (OPTIONS & HHLED_POWER_LIMIT) != 0;
+  static const uint16_t PANELS = (ACTIVE_HEIGHT + 15) / 16;
+  static const uint32_t ROW_BYTES = BYTES_PER_BLOCK * BLOCKS;
+  static const uint32_t PLANE_WORDS = (uint32_t)COLOUR_DEPTH * ADDRESS_PLANES * ROW_BYTES;
+
+public:
+  // Dimensions of the whole chain
+  static const uint16_t WIDTH = 64;
+  static const uint16_t HEIGHT = ACTIVE_HEIGHT;
+
+  // Total frame buffer memory used by this display
+  static constexpr uint32_t FRAME_BUFFER_BYTES = (uint32_t)FRAME_BUFFERS * PLANE_WORDS * (ENCODED ? 5 : 1);
+  static_assert( FRAME_BUFFER_BYTES <= HHLED_MAX_FRAME_BUFFER_BYTES, "Frame buffers exceed HHLED_MAX_FRAME_BUFFER_BYTES" );
+
+  // What it costs the platform to refresh these panels, see MBI5034RefreshCost.h
+  static constexpr MBI5034RefreshCost REFRESH_COST = PLATFORMTYPE::GetRefreshCost(COLOUR_DEPTH, ADDRESS_PLANES, BYTES_PER_BLOCK * BLOCKS, BLOCKS);
+  static_assert( REFRESH_COST.MeetsTarget(), "Rows can't all be shifted out within the refresh interval, reduce COLOUR_DEPTH or lengthen it" );
+
+private:
+  PLATFORMTYPE _platform;     // Driver refreshing these panels
+  byte buffers[FRAME_BUFFERS][COLOUR_DEPTH][ADDRESS_PLANES][BYTES_PER_BLOCK * BLOCKS];  // [buffer][bit][plane][chip]
+  byte (*frameBuffers)[ADDRESS_PLANES][BYTES_PER_BLOCK * BLOCKS];                        // The buffer being drawn on
+  uint32_t outputWords[ENCODED ? FRAME_BUFFERS * PLANE_WORDS : 1];  // GPIO words for each buffer, when encoded
+  uint8_t occupancy[FRAME_BUFFERS][ADDRESS_PLANES];  // For each address plane, a bit for each depth that might have anything lit
+  uint8_t *_occupied;         // Occupancy of the buffer being drawn on
+  uint8_t _dirtyPlanes = 0;   // Address planes changed since they were last encoded and checked
+
+  // LEDs lit on each bit plane of red, green and blue for each address plane, when power limited
+  typedef uint16_t LitCounts[POWER_LIMIT ? COLOUR_DEPTH : 1][3];
+  LitCounts litCounts[POWER_LIMIT ? FRAME_BUFFERS : 1][ADDRESS_PLANES];
+  HHLedPowerGovernor _governor;
+  uint16_t _brightness = 0;         // As asked for, before turning down to limit the power
+  uint16_t _dimming = 256;
+  uint16_t _appliedBrightness = 0;  // As last given to the platform
+
+  // Address of a pixel: offset of its byte within a plane, split into the parts
+  // depending on the column and row, plus the address plane and data line bit
+  static constexpr int16_t ColumnOffset(int16_t x)
+  {
+    return (x & 7) + (x >> 3) * 3 * LEDS_PER_CHIP;
+  }
+
+  static constexpr int16_t RowOffset(int16_t y)
+  {
+    return ((y >> 2) & 1) * 8 + (y / BLOCK_HEIGHT) * BYTES_PER_BLOCK;
+  }
+
+  static constexpr byte AddressPlane(int16_t y)
+  {
+    return y & 3;
+  }
+
+  static constexpr byte DataLine(int16_t y)
+  {
+    return (y % BLOCK_HEIGHT) >> 3;
+  }
+  
+public:
+  HHLedPanel_Chain_impl()
+  {
+    // With double buffering, draw on the second buffer while the first is shown
+    frameBuffers = buffers[FRAME_BUFFERS - 1];
+    _occupied = occupancy[FRAME_BUFFERS - 1];
+  }
+  
+  void initialise(uint16_t maxBrightnessPercent, const MBI5034PinMap *pins = 0)
+  {
+	// Setup the hardware, on the platform's default pins unless given others
+	_platform.Initialise(buffers[0][0][0], COLOUR_DEPTH, ADDRESS_PLANES, BYTES_PER_BLOCK * BLOCKS, BLOCKS, pins);
+	
+	// Clear the screen
+	memset(buffers, 0, sizeof(buffers));
+	memset(occupancy, 0, sizeof(occupancy));
+	memset(litCounts, 0, sizeof(litCounts));
+	
+	if(ENCODED)
+	{
+	  // Translate the blank frames, then refresh from the words instead
+	  for(uint8_t buffer = 0; buffer < FRAME_BUFFERS; buffer++)
+	    _platform.EncodeOutput(buffers[buffer][0][0], &outputWords[buffer * PLANE_WORDS], PLANE_WORDS);
+	}
+	_platform.PresentFrame(buffers[0][0][0], ENCODED ? outputWords : 0, occupancy[0]);
+
+	// Set the base brightness
+	_brightness = _appliedBrightness = maxBrightnessPercent;
+	_platform.SetBrightness(maxBrightnessPercent);
+  }
+  
+  void begin()
+  {
+	// Start refrshing the screen
+	_platform.StartDisplay();
+  }
+
+  // Change the brightness (current gain) while running, from the next refresh cycle
+  void setBrightness(uint16_t brightnessPercent)
+  {
+    _brightness = brightnessPercent;
+    if(POWER_LIMIT)
+      ApplyPowerScale();
+    else
+      _platform.SetBrightness(brightnessPercent);
+  }
+
+  // Dim below the current gain, from 0 (off) to 255 (fully on)
+  void setDimming(uint8_t level)
+  {
+    _dimming = level == 255 ? 256 : level;
+    if(POWER_LIMIT)
+      ApplyPowerScale();
+    else
+      _platform.SetDimming(level);
+  }
+
+  // The current estimate and budget, with HHLED_POWER_LIMIT
+  HHLedPowerGovernor &getPowerGovernor()
+  {
+    static_assert( POWER_LIMIT, "Power limiting needs the HHLED_POWER_LIMIT option" );
+    return _governor;
+  }
+
+  // The driver instance, e.g. for its refresh rate
+  PLATFORMTYPE &getPlatform()
+  {
+    return _platform;
+  }
+
+  // Dimension of the total panel
+  inline uint32_t getWidth() const
+  {
+	return WIDTH;
+  }
+
+  inline uint32_t getHeight() const
+  {
+    return HEIGHT;
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t col) 
+	{
+    // Clip to panel
+    if(x < 0 || x >= getWidth() || y < 0 || y >= getHeight())
+      return;
+
+    drawPixelPreclipped(x, y, col);
+  }
+
+  // Draw a pixel already known to be within the panel
+  void drawPixelPreclipped(int16_t x, int16_t y, uint16_t col) 
+	{
+    WritePixel(AddressPlane(y), ColumnOffset(x) + RowOffset(y), 1 << DataLine(y), col);
+	}
+
+  // Read back the levels a pixel is lit at, 0 to 2^COLOUR_DEPTH - 1 for each of
+  // red, green and blue (after gamma correction), from the frame being drawn on,
+  // or from any other frame buffers laid out the same, e.g. as latched by a
+  // simulated platform
+  void decodePixel(int16_t x, int16_t y, uint8_t levels[3], const byte *frame = 0) const
+  {
+    levels[0] = levels[1] = levels[2] = 0;
+    if(x < 0 || x >= (int16_t)getWidth() || y < 0 || y >= (int16_t)getHeight())
+      return;
+    if(!frame)
+      frame = frameBuffers[0][0];
+
+    const byte *p = frame + AddressPlane(y) * ROW_BYTES + ColumnOffset(x) + RowOffset(y);
+    byte b = 1 << DataLine(y);
+    for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++, p += ADDRESS_PLANES * ROW_BYTES)
+    {
+      // Red, green and blue from the red, green and blue LEDs, top bit first
+      for(uint8_t colour = 0; colour < 3; colour++)
+        levels[colour] = (levels[colour] << 1) | ((p[(2 - colour) * LEDS_PER_CHIP] & b) != 0);
+    }
+  }
+
+  // Draw a run of n pixels along row y from x0 onwards. The address plane and
+  // data line bit are the same for the whole row, so only the offset changes,
+  // and whole chip groups are encoded 8 pixels at a time
+  void encodeRow(int16_t y, int16_t x0, const uint16_t *colours, int16_t n, bool bigEndian = false)
+  {
+    // Clip to panel
+    if(y < 0 || y >= (int16_t)getHeight())
+      return;
+    if(x0 < 0)
+    {
+      colours -= x0;
+      n += x0;
+      x0 = 0;
+    }
+    if(n > (int16_t)getWidth() - x0)
+      n = getWidth() - x0;
+
+    int16_t base = RowOffset(y);
+    byte row = AddressPlane(y);
+    byte line = DataLine(y);
+    int16_t x = x0;
+    int16_t x1 = x0 + n;
+
+    // Single pixels up to the start of the first whole chip group
+    for(; x < x1 && (x & 7); x++)
+    {
+      uint16_t col = *colours++;
+      if(bigEndian)
+        col = (col >> 8) | (col << 8);
+      WritePixel(row, base + ColumnOffset(x), 1 << line, col);
+    }
+
+    // Whole chip groups, 8 pixels at a time
+    for(; x + 8 <= x1; x += 8, colours += 8)
+    {
+      EncodeGroup(row, base + ColumnOffset(x), line, colours, bigEndian);
+    }
+
+    // Any pixels left over
+    for(; x < x1; x++)
+    {
+      uint16_t col = *colours++;
+      if(bigEndian)
+        col = (col >> 8) | (col << 8);
+      WritePixel(row, base + ColumnOffset(x), 1 << line, col);
+    }
+  }
+
+  // Draw a run of n pixels down column x from y0 onwards
+  void encodeColumn(int16_t x, int16_t y0, const uint16_t *colours, int16_t n, bool bigEndian = false)
+  {
+    // Clip to panel
+    if(x < 0 || x >= (int16_t)getWidth())
+      return;
+    if(y0 < 0)
+    {
+      colours -= y0;
+      n += y0;
+      y0 = 0;
+    }
+    if(n > (int16_t)getHeight() - y0)
+      n = getHeight() - y0;
+
+    int16_t base = ColumnOffset(x);
+
+    for(int16_t y = y0; y < y0 + n; y++)
+    {
+      uint16_t col = *colours++;
+      if(bigEndian)
+        col = (col >> 8) | (col << 8);
+      WritePixel(AddressPlane(y), base + RowOffset(y), 1 << DataLine(y), col);
+    }
+  }
+
+  // Fill a rectangle with a single colour. The colour is split and gamma-corrected
+  // once, then each row is written as runs of consecutive bytes within each
+  // 8-pixel chip group rather than pixel by pixel
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t col)
+  {
+    // Clip to panel
+    const int16_t width = getWidth();
+    const int16_t height = getHeight();
+    if(x < 0)
+    {
+      w += x;
+      x = 0;
+    }
+    if(y < 0)
+    {
+      h += y;
+      y = 0;
+    }
+    if(w <= 0 || h <= 0 || x >= width || y >= height)
+      return;
+    if(w > width - x)
+      w = width - x;
+    if(h > height - y)
+      h = height - y;
+
+    byte masks[COLOUR_DEPTH][3];
+    EncodeColour(col, masks);
+
+    // Rows 8 apart within a block share the same bytes, using a different data line
+    // bit each, so all the rows of the rectangle sharing a byte are written together
+    int16_t y1 = y + h;
+    for(int16_t block = y - y % BLOCK_HEIGHT; block < y1; block += BLOCK_HEIGHT)
+    {
+      for(uint8_t row = 0; row < 8; row++)
+      {
+        byte b = 0;
+        for(uint8_t line = 0; line < LINES_PER_BLOCK; line++)
+        {
+          int16_t py = block + line * 8 + row;
+          if(py >= y && py < y1)
+            b |= 1 << line;
+        }
+        if(b)
+          WriteRun(x, x + w, AddressPlane(row), RowOffset(block + row), b, masks);
+      }
+    }
+  }
+
+  void drawHLine(int16_t x, int16_t y, int16_t w, uint16_t col)
+  {
+    fillRect(x, y, w, 1, col);
+  }
+
+  void drawVLine(int16_t x, int16_t y, int16_t h, uint16_t col)
+  {
+    fillRect(x, y, 1, h, col);
+  }
+
+  // Fill the whole panel with a single colour. Every byte of a solid colour is
+  // either 0x00 or 0xff, fixed for each depth and colour, so each plane is just
+  // a repeated pattern of 16 bytes each of blue, green and red
+  void Fill(uint16_t col)
+  {
+    byte masks[COLOUR_DEPTH][3];
+    EncodeColour(col, masks);
+
+    // Only whole blocks can be filled this way, the data lines of any
+    // panels that aren't there are left blank
+    const uint16_t fullBlocks = ACTIVE_HEIGHT / BLOCK_HEIGHT;
+    const byte lines = (1 << LINES_PER_BLOCK) - 1;
+
+    // Everything is replaced, so the lit bit planes are known exactly
+    uint8_t depths = 0;
+    for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+      if(fullBlocks && (masks[depth][0] | masks[depth][1] | masks[depth][2]))
+        depths |= 1 << depth;
+    MarkAllDirty(depths);
+
+    for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+    {
+      byte *plane = frameBuffers[depth][0];
+      for(uint16_t chip = 0; chip < sizeof(frameBuffers[0][0]); chip += 3*LEDS_PER_CHIP)
+      {
+        byte active = chip < fullBlocks * BYTES_PER_BLOCK ? lines : 0;
+        memset(plane + chip, masks[depth][0] & active, LEDS_PER_CHIP);
+        memset(plane + chip + LEDS_PER_CHIP, masks[depth][1] & active, LEDS_PER_CHIP);
+        memset(plane + chip + 2*LEDS_PER_CHIP, masks[depth][2] & active, LEDS_PER_CHIP);
+      }
+      // All the address planes are the same
+      for(uint8_t row = 1; row < ADDRESS_PLANES; row++)
+      {
+        memcpy(frameBuffers[depth][row], plane, sizeof(frameBuffers[0][0]));
+      }
+    }
+
+    // Then the rows of any partial block
+    if(fullBlocks * BLOCK_HEIGHT < ACTIVE_HEIGHT)
+      fillRect(0, fullBlocks * BLOCK_HEIGHT, getWidth(), ACTIVE_HEIGHT - fullBlocks * BLOCK_HEIGHT, col);
+  }
+
+  // Go over the address planes changed since the last call, checking which bit
+  // planes are now blank and translating them into the GPIO words the refresh
+  // writes out, when encoded. Until then the refresh carries on showing the
+  // planes as they were.
+  void commit()
+  {
+    uint32_t *words = OutputWords(frameBuffers);
+    for(uint8_t row = 0; row < ADDRESS_PLANES; row++)
+    {
+      if(!(_dirtyPlanes & (1 << row)))
+        continue;
+
+      uint8_t occupied = 0;
+      for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+      {
+        if(POWER_LIMIT ? CountLit(frameBuffers[depth][row], LitCountsOf(frameBuffers)[row][POWER_LIMIT ? depth : 0])
+                       : !IsBlank(frameBuffers[depth][row]))
+          occupied |= 1 << depth;
+        if(ENCODED)
+          _platform.EncodeOutput(frameBuffers[depth][row], words + (depth * ADDRESS_PLANES + row) * ROW_BYTES, ROW_BYTES);
+      }
+      _occupied[row] = occupied;
+    }
+    _dirtyPlanes = 0;
+
+    // Double buffered, nothing is shown until present()
+    if(POWER_LIMIT && FRAME_BUFFERS == 1)
+      LimitPower(true);
+  }
+
+  // Show the frame drawn since the last call, when double buffered. The refresh
+  // only switches to it at the end of a whole refresh cycle, so a partly drawn
+  // frame is never shown. Drawing then carries on in the other buffer, starting
+  // from a copy of the frame just presented unless copyFrame is false.
+  void present(bool copyFrame = true)
+  {
+    commit();
+    if(FRAME_BUFFERS == 1)
+      return;
+
+    // Dimmed for the new frame from the moment it is shown, not before or after
+    byte (*shown)[ADDRESS_PLANES][BYTES_PER_BLOCK * BLOCKS] = frameBuffers;
+    uint8_t *shownOccupancy = _occupied;
+    int16_t dimming = POWER_LIMIT ? LimitPower(false) : -1;
+    _platform.PresentFrame(shown[0][0], ENCODED ? OutputWords(shown) : 0, shownOccupancy, dimming);
+
+    // The other buffer is still being shown until the refresh cycle ends
+    while(_platform.FramePending())
+      yield();
+
+    frameBuffers = (shown == buffers[0]) ? buffers[1] : buffers[0];
+    _occupied = (shown == buffers[0]) ? occupancy[1] : occupancy[0];
+    if(copyFrame)
+    {
+      memcpy(frameBuffers, shown, sizeof(buffers[0]));
+      memcpy(_occupied, shownOccupancy, sizeof(occupancy[0]));
+      if(POWER_LIMIT)
+        memcpy(LitCountsOf(frameBuffers), LitCountsOf(shown), sizeof(litCounts[0]));
+      if(ENCODED)
+        memcpy(OutputWords(frameBuffers), OutputWords(shown), PLANE_WORDS * sizeof(uint32_t));
+    }
+    else
+    {
+      // Nothing known about what is in the new buffer
+      _dirtyPlanes = (1 << ADDRESS_PLANES) - 1;
+      memset(_occupied, 0xff, sizeof(occupancy[0]));
+    }
+  }
+
+  void Clear(bool toWhite = false)
+  {
+    FillBuffer(toWhite ? 0xff : 0);
+  }
+
+private:
+  // The GPIO words for the given frame buffer
+  uint32_t *OutputWords(byte (*frame)[ADDRESS_PLANES][BYTES_PER_BLOCK * BLOCKS])
+  {
+    return ENCODED ? &outputWords[(frame == buffers[0] ? 0 : 1) * PLANE_WORDS] : outputWords;
+  }
+
+  // The lit LED counts for the given frame buffer
+  LitCounts *LitCountsOf(byte (*frame)[ADDRESS_PLANES][BYTES_PER_BLOCK * BLOCKS])
+  {
+    return litCounts[POWER_LIMIT && frame != buffers[0] ? 1 : 0];
+  }
+
+  // Count the LEDs lit on a bit plane of one address plane, for red, green and
+  // blue, returning whether there are any
+  static bool CountLit(const byte *plane, uint16_t counts[3])
+  {
+    uint32_t lit[3] = { 0, 0, 0 };
+    for(uint16_t chip = 0; chip < ROW_BYTES; chip += 3*LEDS_PER_CHIP)
+    {
+      // Blue, green then red LED
+      for(uint8_t led = 0; led < 3; led++)
+      {
+        for(uint16_t n = 0; n < LEDS_PER_CHIP; n += sizeof(uint32_t))
+        {
+          uint32_t bytes;
+          memcpy(&bytes, plane + chip + led * LEDS_PER_CHIP + n, sizeof(bytes));
+          lit[2 - led] += __builtin_popcount(bytes);
+        }
+      }
+    }
+    for(uint8_t colour = 0; colour < 3; colour++)
+      counts[colour] = lit[colour];
+    return lit[0] | lit[1] | lit[2];
+  }
+
+  // Estimate the current of the frame just committed, weighting the LEDs lit
+  // on each bit by its on-time, and turn the display down to keep within budget,
+  // returning the dimming level for the frame
+  uint8_t LimitPower(bool applyDimming)
+  {
+    uint32_t lit[3] = { 0, 0, 0 };
+    LitCounts *counts = LitCountsOf(frameBuffers);
+    for(uint8_t row = 0; row < ADDRESS_PLANES; row++)
+      for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+        for(uint8_t colour = 0; colour < 3; colour++)
+          lit[colour] += (uint32_t)counts[row][POWER_LIMIT ? depth : 0][colour] << (COLOUR_DEPTH - depth - 1);
+
+    const uint32_t full = (uint32_t)WIDTH * HEIGHT * ((1 << COLOUR_DEPTH) - 1);
+    _governor.Update(PANELS, lit, full, _brightness, _dimming);
+    return ApplyPowerScale(applyDimming);
+  }
+
+  // Show at the brightness asked for, turned down by the governor's scale. The
+  // gain is written to the chips at the end of the refresh cycle, and the
+  // dimming level returned is set now unless applyDimming is false.
+  uint8_t ApplyPowerScale(bool applyDimming = true)
+  {
+    const uint16_t scale = _governor.GetScale();
+    uint16_t brightness = _brightness;
+    uint32_t dimming = _dimming;
+    if(_governor.UsesGain())
+    {
+      // Down to the lowest gain, then any further by dimming
+      uint32_t gain = (uint32_t)_brightness * scale / HHLedPowerGovernor::FULL_SCALE;
+      if(brightness > HHLedPowerGovernor::MIN_GAIN_PERCENT)
+        brightness = gain > HHLedPowerGovernor::MIN_GAIN_PERCENT ? gain : HHLedPowerGovernor::MIN_GAIN_PERCENT;
+      if(gain < brightness)
+        dimming = dimming * gain / brightness;
+    }
+    else
+    {
+      dimming = dimming * scale / HHLedPowerGovernor::FULL_SCALE;
+    }
+
+    // Only write the gain to the chips when it changes
+    if(brightness != _appliedBrightness)
+    {
+      _platform.SetBrightness(brightness);
+      _appliedBrightness = brightness;
+    }
+    uint8_t level = dimming >= 255 ? 255 : dimming;
+    if(applyDimming)
+      _platform.SetDimming(level);
+    return level;
+  }
+
+  // Note an address plane has been drawn on, with something lit on the given depths
+  inline void MarkDirty(byte row, uint8_t depths)
+  {
+    _dirtyPlanes |= 1 << row;
+    _occupied[row] |= depths;
+  }
+
+  // Note every address plane has been replaced, with just the given depths lit.
+  // Encoded and single buffered, the refresh carries on showing the old words
+  // until commit(), so as with MarkDirty they are only added to until then
+  inline void MarkAllDirty(uint8_t depths)
+  {
+    for(byte row = 0; row < ADDRESS_PLANES; row++)
+      _occupied[row] = (ENCODED && FRAME_BUFFERS == 1 ? _occupied[row] : 0) | depths;
+    _dirtyPlanes = (1 << ADDRESS_PLANES) - 1;
+  }
+
+  // Check whether a bit plane of one address plane is all zero
+  static bool IsBlank(const byte *plane)
+  {
+    uint32_t any = 0;
+    for(uint16_t n = 0; n < ROW_BYTES; n += sizeof(any))
+    {
+      uint32_t bytes;
+      memcpy(&bytes, plane + n, sizeof(bytes));
+      any |= bytes;
+    }
+    return any == 0;
+  }
+
+  // Set the colour of one pixel given its offset, address plane and data line bit
+  void WritePixel(byte row, int16_t off, byte b, uint16_t col)
+  {
+    // Split the colour into RGB parts and look up which bit planes each one is on in
+    uint8_t red = GammaPlanes<COLOUR_DEPTH, 32, 1>::value[col >> 11];
+    uint8_t green = GammaPlanes<COLOUR_DEPTH, 64, 0>::value[(col >> 5) & 0x3f];
+    uint8_t blue = GammaPlanes<COLOUR_DEPTH, 32, 1>::value[col & 0x1f];
+    MarkDirty(row, red | green | blue);
+
+    for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++, red >>= 1, green >>= 1, blue >>= 1)
+    {
+      byte *p = &frameBuffers[depth][row][off];
+      // Blue, green then red LED, without branching on each bit
+      p[0] = (p[0] & ~b) | (-(blue & 1) & b);
+      p[LEDS_PER_CHIP] = (p[LEDS_PER_CHIP] & ~b) | (-(green & 1) & b);
+      p[2*LEDS_PER_CHIP] = (p[2*LEDS_PER_CHIP] & ~b) | (-(red & 1) & b);
+    }
+  }
+
+  // Encode the 8 pixels of a chip group starting at offset off in one go.
+  //
+  // Each pixel has its own byte in the chip group and the row its own data line bit
+  // within each byte, so per colour this is an 8x8 bit matrix transpose from 8 pixel
+  // values to 8 bit planes. With the gamma-corrected values gathered one per byte of
+  // a 64-bit word, the bytes are already in pixel order, so the transpose for each
+  // depth is just shifting that bit of every byte down to bit 0 and back up to the
+  // data line bit, then merging all 8 output bytes with a single 64-bit write.
+  void EncodeGroup(byte row, int16_t off, byte line, const uint16_t *colours, bool bigEndian)
+  {
+    const uint64_t ones = 0x0101010101010101ULL;
+
+    uint64_t red = 0;
+    uint64_t green = 0;
+    uint64_t blue = 0;
+    for(uint8_t i = 0; i < 8; i++)
+    {
+      uint16_t col = colours[i];
+      if(bigEndian)
+        col = (col >> 8) | (col << 8);
+      red |= (uint64_t)gamma6[(col >> 10) & 0x3e] << (i * 8);
+      green |= (uint64_t)gamma6[(col >> 5) & 0x3f] << (i * 8);
+      blue |= (uint64_t)gamma6[(col << 1) & 0x3e] << (i * 8);
+    }
+
+    // Gamma bits lit by any of the pixels
+    uint64_t lit = red | green | blue;
+    lit |= lit >> 32;
+    lit |= lit >> 16;
+    lit |= lit >> 8;
+    uint8_t depths = 0;
+    for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+      depths |= ((lit >> (7 - depth)) & 1) << depth;
+    MarkDirty(row, depths);
+
+    const uint64_t keep = ~(ones << line);
+    for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+    {
+      byte *p = &frameBuffers[depth][row][off];
+      byte shift = 7 - depth;
+      MergeGroup(p, (((blue >> shift) & ones) << line), keep);
+      MergeGroup(p + LEDS_PER_CHIP, (((green >> shift) & ones) << line), keep);
+      MergeGroup(p + 2*LEDS_PER_CHIP, (((red >> shift) & ones) << line), keep);
+    }
+  }
+
+  // Replace the bits not in keep of the 8 bytes at p, in pixel order
+  static inline void MergeGroup(byte *p, uint64_t bits, uint64_t keep)
+  {
+    uint64_t bytes;
+    memcpy(&bytes, p, sizeof(bytes));
+    bytes = (bytes & keep) | bits;
+    memcpy(p, &bytes, sizeof(bytes));
+  }
+
+  // Split the colour into RGB parts and expand the bit for each colour depth
+  // into a byte mask (0x00 or 0xff) in blue, green, red order
+  void EncodeColour(uint16_t col, byte masks[COLOUR_DEPTH][3])
+  {
+    uint8_t red = GammaPlanes<COLOUR_DEPTH, 32, 1>::value[col >> 11];
+    uint8_t green = GammaPlanes<COLOUR_DEPTH, 64, 0>::value[(col >> 5) & 0x3f];
+    uint8_t blue = GammaPlanes<COLOUR_DEPTH, 32, 1>::value[col & 0x1f];
+
+    for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++, red >>= 1, green >>= 1, blue >>= 1)
+    {
+      masks[depth][0] = -(blue & 1);
+      masks[depth][1] = -(green & 1);
+      masks[depth][2] = -(red & 1);
+    }
+  }
+
+  // Write the pre-encoded colour to pixels x to x1-1 of all rows in the given address
+  // plane whose data line bits are set in b, already clipped
+  void WriteRun(int16_t x, int16_t x1, byte row, int16_t base, byte b, const byte masks[COLOUR_DEPTH][3])
+  {
+    for(uint8_t depth = 0; depth < COLOUR_DEPTH; depth++)
+    {
+      byte *plane = &frameBuffers[depth][row][base];
+      byte blue = masks[depth][0] & b;
+      byte green = masks[depth][1] & b;
+      byte red = masks[depth][2] & b;
+      MarkDirty(row, (blue | green | red) ? 1 << depth : 0);
+
+      for(int16_t px = x; px < x1; )
+      {
+        // Consecutive pixels within a chip group are consecutive bytes
+        byte *p = plane + ColumnOffset(px);
+        int16_t end = (px | 7) + 1;
+        if(end > x1)
+          end = x1;
+        if(b == 0xff)
+        {
+          // Whole bytes, so no need to preserve other rows
+          memset(p, blue, end - px);
+          memset(p + LEDS_PER_CHIP, green, end - px);
+          memset(p + 2*LEDS_PER_CHIP, red, end - px);
+          px = end;
+          continue;
+        }
+        for(; px < end; px++, p++)
+        {
+          p[0] = (p[0] & ~b) | blue;
+          p[LEDS_PER_CHIP] = (p[LEDS_PER_CHIP] & ~b) | green;
+          p[2*LEDS_PER_CHIP] = (p[2*LEDS_PER_CHIP] & ~b) | red;
+        }
+      }
+    }
+  }
+
+  void FillBuffer(byte b = 0)
+	{
+      // Quick clear to solid colour (normally black or white)
+      memset(frameBuffers, b, sizeof(buffers[0]));
+      MarkAllDirty(b ? (1 << COLOUR_DEPTH) - 1 : 0);
+	}	
+};
+
+template<class PLATFORMTYPE, uint8_t PANELS_PER_BLOCK, uint8_t BLOCKS, uint16_t ACTIVE_HEIGHT, unsigned short COLOUR_DEPTH, uint8_t OPTIONS>
+constexpr uint32_t HHLedPanel_Chain_impl<PLATFORMTYPE, PANELS_PER_BLOCK, BLOCKS, ACTIVE_HEIGHT, COLOUR_DEPTH, OPTIONS>::FRAME_BUFFER_BYTES;
+
+template<class PLATFORMTYPE, uint8_t PANELS_PER_BLOCK, uint8_t BLOCKS, uint16_t ACTIVE_HEIGHT, unsigned short COLOUR_DEPTH, uint8_t OPTIONS>
+constexpr MBI5034RefreshCost HHLedPanel_Chain_impl<PLATFORMTYPE, PANELS_PER_BLOCK, BLOCKS, ACTIVE_HEIGHT, COLOUR_DEPTH, OPTIONS>::REFRESH_COST;
@@ -0,0 +1,289 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class wraps any of the panel implementations to add a shadow RGB565 copy
+of the display, e.g.
+  HHLedPanel<HHLedPanel_Shadow_impl<HHLedPanel_4x64x16_impl<ESP32_4xMBI5034, 6>>>
+
+Drawing only updates the shadow copy, which can be read back with readPixel
+for blending, anti-aliasing or XOR cursors. The rows changed since the last
+commit() are then encoded into the bit planes in one go with the bulk row
+encoder, so pixels overwritten several times in a frame are only encoded once.
+Nothing drawn is shown until commit() (or present()) is called.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+
+template<class PANELTYPE> class HHLedPanel_Shadow_impl
+{
+public:
+  static const uint16_t WIDTH = PANELTYPE::WIDTH;
+  static const uint16_t HEIGHT = PANELTYPE::HEIGHT;
+  static_assert( WIDTH < 256, "Dirty columns are kept as bytes" );
+
+private:
+  PANELTYPE _panel;
+  uint16_t _pixels[HEIGHT][WIDTH];
+
+  // Columns changed on each row since the last commit, none if start >= end
+  uint8_t _dirtyStart[HEIGHT];
+  uint8_t _dirtyEnd[HEIGHT];
+
+  // A fill of the whole screen waiting for the next commit, under any dirty rows
+  enum PendingFill : uint8_t { FILL_NONE, FILL_COLOUR, FILL_BLACK, FILL_WHITE };
+  PendingFill _pendingFill = FILL_NONE;
+  uint16_t _fillColour = 0;
+  
+public:
+  HHLedPanel_Shadow_impl()
+  {
+  }
+  
+  void initialise(uint16_t maxBrightnessPercent, const MBI5034PinMap *pins = 0)
+  {
+    _panel.initialise(maxBrightnessPercent, pins);
+    memset(_pixels, 0, sizeof(_pixels));
+    _pendingFill = FILL_NONE;
+    MarkClean();
+  }
+  
+  void begin()
+  {
+    _panel.begin();
+  }
+
+  void setBrightness(uint16_t brightnessPercent)
+  {
+    _panel.setBrightness(brightnessPercent);
+  }
+
+  void setDimming(uint8_t level)
+  {
+    _panel.setDimming(level);
+  }
+
+  auto getPlatform() -> decltype(_panel.getPlatform())
+  {
+    return _panel.getPlatform();
+  }
+
+  auto getPowerGovernor() -> decltype(_panel.getPowerGovernor())
+  {
+    return _panel.getPowerGovernor();
+  }
+
+  // Dimension of the total panel
+  inline uint32_t getWidth() const
+  {
+    return WIDTH;
+  }
+
+  inline uint32_t getHeight() const
+  {
+    return HEIGHT;
+  }
+
+  // Colour of a pixel as last drawn, whether committed or not
+  uint16_t readPixel(int16_t x, int16_t y) const
+  {
+    if(x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
+      return 0;
+    return _pixels[y][x];
+  }
+
+  // Levels a pixel is lit at in the bit planes, i.e. as of the last commit
+  void decodePixel(int16_t x, int16_t y, uint8_t levels[3], const byte *frame = 0) const
+  {
+    _panel.decodePixel(x, y, levels, frame);
+  }
+
+  // Encode the rows changed since the last commit into the bit planes
+  void commit()
+  {
+    // Any whole screen fill first, then what was drawn over it
+    if(_pendingFill == FILL_COLOUR)
+      _panel.Fill(_fillColour);
+    else if(_pendingFill != FILL_NONE)
+      _panel.Clear(_pendingFill == FILL_WHITE);
+    _pendingFill = FILL_NONE;
+
+    for(int16_t y = 0; y < HEIGHT; y++)
+    {
+      if(_dirtyStart[y] < _dirtyEnd[y])
+      {
+        _panel.encodeRow(y, _dirtyStart[y], &_pixels[y][_dirtyStart[y]], _dirtyEnd[y] - _dirtyStart[y]);
+      }
+    }
+    MarkClean();
+
+    // Then on to the GPIO words, if the panel keeps them
+    _panel.commit();
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t col) 
+  {
+    // Clip to panel
+    if(x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
+      return;
+
+    drawPixelPreclipped(x, y, col);
+  }
+
+  // Draw a pixel already known to be within the panel
+  void drawPixelPreclipped(int16_t x, int16_t y, uint16_t col) 
+  {
+    _pixels[y][x] = col;
+    MarkDirty(y, x, x + 1);
+  }
+
+  // Draw a run of n pixels along row y from x0 onwards
+  void encodeRow(int16_t y, int16_t x0, const uint16_t *colours, int16_t n, bool bigEndian = false)
+  {
+    // Clip to panel
+    if(y < 0 || y >= HEIGHT)
+      return;
+    if(x0 < 0)
+    {
+      colours -= x0;
+      n += x0;
+      x0 = 0;
+    }
+    if(n > WIDTH - x0)
+      n = WIDTH - x0;
+    if(n <= 0)
+      return;
+
+    uint16_t *p = &_pixels[y][x0];
+    for(int16_t i = 0; i < n; i++)
+    {
+      uint16_t col = *colours++;
+      *p++ = bigEndian ? (col >> 8) | (col << 8) : col;
+    }
+    MarkDirty(y, x0, x0 + n);
+  }
+
+  // Draw a run of n pixels down column x from y0 onwards
+  void encodeColumn(int16_t x, int16_t y0, const uint16_t *colours, int16_t n, bool bigEndian = false)
+  {
+    // Clip to panel
+    if(x < 0 || x >= WIDTH)
+      return;
+    if(y0 < 0)
+    {
+      colours -= y0;
+      n += y0;
+      y0 = 0;
+    }
+    if(n > HEIGHT - y0)
+      n = HEIGHT - y0;
+
+    for(int16_t y = y0; y < y0 + n; y++)
+    {
+      uint16_t col = *colours++;
+      _pixels[y][x] = bigEndian ? (col >> 8) | (col << 8) : col;
+      MarkDirty(y, x, x + 1);
+    }
+  }
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t col)
+  {
+    // Clip to panel
+    if(x < 0)
+    {
+      w += x;
+      x = 0;
+    }
+    if(y < 0)
+    {
+      h += y;
+      y = 0;
+    }
+    if(w <= 0 || h <= 0 || x >= WIDTH || y >= HEIGHT)
+      return;
+    if(w > WIDTH - x)
+      w = WIDTH - x;
+    if(h > HEIGHT - y)
+      h = HEIGHT - y;
+
+    for(int16_t y1 = y + h; y < y1; y++)
+    {
+      uint16_t *p = &_pixels[y][x];
+      for(int16_t i = 0; i < w; i++)
+        *p++ = col;
+      MarkDirty(y, x, x + w);
+    }
+  }
+
+  void drawHLine(int16_t x, int16_t y, int16_t w, uint16_t col)
+  {
+    fillRect(x, y, w, 1, col);
+  }
+
+  void drawVLine(int16_t x, int16_t y, int16_t h, uint16_t col)
+  {
+    fillRect(x, y, 1, h, col);
+  }
+
+  // The whole screen is quicker to fill directly than to encode row by row, so
+  // the fill is kept until the next commit and anything drawn before is dropped
+  void Fill(uint16_t col)
+  {
+    for(int16_t y = 0; y < HEIGHT; y++)
+      for(int16_t x = 0; x < WIDTH; x++)
+        _pixels[y][x] = col;
+    _pendingFill = FILL_COLOUR;
+    _fillColour = col;
+    MarkClean();
+  }
+
+  // Commit any changes, then show the frame if double buffered
+  void present(bool copyFrame = true)
+  {
+    commit();
+    _panel.present(copyFrame);
+  }
+
+  void Clear(bool toWhite = false)
+  {
+    memset(_pixels, toWhite ? 0xff : 0, sizeof(_pixels));
+    _pendingFill = toWhite ? FILL_WHITE : FILL_BLACK;
+    MarkClean();
+  }
+
+private:
+  inline void MarkDirty(int16_t y, int16_t x0, int16_t x1)
+  {
+    if(x0 < _dirtyStart[y])
+      _dirtyStart[y] = x0;
+    if(x1 > _dirtyEnd[y])
+      _dirtyEnd[y] = x1;
+  }
+
+  void MarkClean()
+  {
+    memset(_dirtyStart, WIDTH, sizeof(_dirtyStart));
+    memset(_dirtyEnd, 0, sizeof(_dirtyEnd));
+  }
+};
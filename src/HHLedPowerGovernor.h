@@ -0,0 +1,150 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+This class estimates the current a set of panels will draw showing a frame,
+and works out how far to turn the display down to keep within a budget, so
+sparse content can be shown brighter without full white frames tripping the
+power supply.
+
+The estimate is built from how many LEDs are lit on each colour channel, each
+weighted by the on-time of the bit it is lit on, as a share of every LED being
+fully on. The drivers are constant current, so that share is taken to scale
+linearly with the current gain and the output enable dimming, on top of a
+fixed current for the panels just being powered. The defaults come from full
+white on four panels drawing around 6A at 12% and around 40A at 100%, and can
+be replaced with figures measured for other panels or supplies.
+
+Once over budget the display is turned down straight away, for the frame that
+went over. It is only turned back up a step at a time once the content allows,
+so it doesn't visibly pump up and down as frames come and go.
+
+The panels only update it from commit() or present() with the HHLED_POWER_LIMIT
+option, so frames drawn without calling either are never checked against the
+budget.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+
+class HHLedPowerGovernor
+{
+public:
+  // Current of each 64x16 panel just being powered, and more with each colour
+  // channel fully on at 100% gain, in milliamps
+  static const uint16_t DEFAULT_IDLE_mA = 300;
+  static const uint16_t DEFAULT_CHANNEL_mA = 3233;  // 9700mA for full white
+
+  // Full scale, i.e. not turned down at all
+  static const uint16_t FULL_SCALE = 256;
+
+  // Lowest current gain of the chips
+  static const uint16_t MIN_GAIN_PERCENT = 12;
+
+  // Replace the current model for the panels, per panel
+  void SetModel(uint16_t idle_mA, uint16_t red_mA, uint16_t green_mA, uint16_t blue_mA)
+  {
+    _idle_mA = idle_mA;
+    _channel_mA[0] = red_mA;
+    _channel_mA[1] = green_mA;
+    _channel_mA[2] = blue_mA;
+  }
+
+  // Keep the estimated current within budget_mA, 0 for no limit. Turned down
+  // by the output enable dimming, or the current gain first if useGain is set,
+  // which can only go down to 12%, so any further is then done by dimming.
+  void SetBudget(uint32_t budget_mA, bool useGain = false)
+  {
+    _budget_mA = budget_mA;
+    _useGain = useGain;
+  }
+
+  // How quickly to turn back up once the content allows, as the share of the
+  // way to go covered each frame, 1 (slowest) to 256 (straight away)
+  void SetRiseRate(uint16_t rate)
+  {
+    _riseRate = rate ? rate : 1;
+  }
+
+  // Estimated current for the given panels, with lit[] the lit LEDs of red,
+  // green and blue each weighted by its bit's on-time, out of full per channel
+  // for every LED fully on, at the current gain and dimming (0-256) given
+  uint32_t Estimate(uint16_t panels, const uint32_t lit[3], uint32_t full, uint16_t gainPercent, uint16_t dimming) const
+  {
+    uint64_t channels = 0;
+    for(uint8_t channel = 0; channel < 3; channel++)
+      channels += (uint64_t)lit[channel] * _channel_mA[channel];
+    return (uint32_t)panels * _idle_mA + (uint32_t)(channels * panels * gainPercent * dimming / ((uint64_t)full * 100 * FULL_SCALE));
+  }
+
+  // Work out the scale to show the next frame at, out of FULL_SCALE, from its
+  // estimated current at the brightness asked for
+  uint16_t Update(uint16_t panels, const uint32_t lit[3], uint32_t full, uint16_t gainPercent, uint16_t dimming)
+  {
+    _estimate_mA = Estimate(panels, lit, full, gainPercent, dimming);
+
+    // The part that can be turned down has to fit in what's left after the idle current
+    uint32_t idle_mA = (uint32_t)panels * _idle_mA;
+    uint16_t target = FULL_SCALE;
+    if(_budget_mA && _estimate_mA > _budget_mA)
+      target = _budget_mA > idle_mA ? (uint64_t)(_budget_mA - idle_mA) * FULL_SCALE / (_estimate_mA - idle_mA) : 0;
+
+    if(target < _scale)
+      _scale = target;
+    else
+      _scale += ((uint32_t)(target - _scale) * _riseRate + FULL_SCALE - 1) / FULL_SCALE;
+    return _scale;
+  }
+
+  bool UsesGain() const
+  {
+    return _useGain;
+  }
+
+  // Estimated current of the last frame at the brightness asked for, and the
+  // scale it is being shown at to keep within budget
+  uint32_t GetEstimate() const
+  {
+    return _estimate_mA;
+  }
+
+  uint16_t GetScale() const
+  {
+    return _scale;
+  }
+
+  // and so the estimated current actually drawn
+  uint32_t GetLimitedEstimate(uint16_t panels) const
+  {
+    uint32_t idle_mA = (uint32_t)panels * _idle_mA;
+    return _estimate_mA > idle_mA ? idle_mA + (uint64_t)(_estimate_mA - idle_mA) * _scale / FULL_SCALE : _estimate_mA;
+  }
+
+private:
+  uint16_t _idle_mA = DEFAULT_IDLE_mA;
+  uint16_t _channel_mA[3] = { DEFAULT_CHANNEL_mA, DEFAULT_CHANNEL_mA, DEFAULT_CHANNEL_mA };
+  uint32_t _budget_mA = 0;
+  bool _useGain = false;
+  uint16_t _riseRate = 16;
+  uint16_t _scale = FULL_SCALE;
+  uint32_t _estimate_mA = 0;
+};
@@ -0,0 +1,377 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class is a simulated platform driver with the same interface as the ESP32
+drivers, so the drawing and encoding code can be built and run on a host
+computer, e.g. Linux, without any hardware.
+******************************************************************************/
+#include "HostSimMBI5034.h"
+
+// Statics
+static byte *_frameBuffers; // Array of [depth][bank][leds]
+static byte *_pendingFrameBuffers = 0;  // Next frame to show, when the refresh cycle ends
+static uint32_t *_frameWords = 0;   // Pre-translated GPIO words for _frameBuffers, if any
+static uint32_t *_pendingFrameWords = 0;
+static const uint8_t *_occupancy = 0;  // Depths with anything lit for each bank, if known
+static const uint8_t *_pendingOccupancy = 0;
+static uint8_t _colourDepth;
+static uint8_t _planes;
+static uint16_t _bytesToSend;
+static uint8_t _blocks;
+static uint8_t _parallelBlocks = 1;  // Blocks clocked out together on their own data lines
+static uint16_t _brightness;         // As last written to the chips
+static uint16_t _pendingBrightness = 0;  // To write at the end of the refresh cycle, if not 0
+static uint32_t _controlWrites = 0;
+static uint32_t _skippedRows = 0;
+#if HHLED_REFRESH_STATS
+static MBI5034RefreshStats _stats;
+#endif
+static uint16_t _dimming = 256;
+static int16_t _pendingDimming = -1;  // To switch to with the next frame, if not -1
+static bool _running = false;
+static bool _pinsValid = true;
+static uint16_t _step = 0;
+static uint8_t _bank = 0;
+static uint8_t _depth = 0;
+static uint8_t _maxBitWeight = 0;
+static uint32_t _frameCount = 0;
+static uint32_t _lastWaitedFrame = 0;
+static byte *_shiftRegisters = 0;  // Data line bits held along the chain of each block, as a ring
+static uint16_t *_shiftHead = 0;   // Where the next bit clocked in goes on each ring
+static byte *_latchedData = 0;     // Array of [depth][bank][leds], as last latched
+static uint32_t *_rowWords = 0;    // GPIO words for a row, when not already translated
+static MBI5034Schedule _schedule;  // On-time of each bit
+static uint64_t _time = 0;         // Simulated time in ticks
+static uint64_t _onTime[6];        // Time the outputs have been enabled for each bit
+static uint64_t _frameStart = 0;
+static uint32_t _frameTicks = 0;   // Time the last whole refresh cycle took
+
+// Clock one GPIO word into the shift registers of a group of blocks sharing
+// a clock line, each taking its data lines from its own lane of the word
+static void ClockIn(uint8_t group, uint32_t word)
+{
+  uint16_t bytesPerBlock = _bytesToSend / _blocks;
+  for(uint8_t lane = 0; lane < _parallelBlocks; lane++)
+  {
+    uint8_t block = group * _parallelBlocks + lane;
+    if(block >= _blocks)
+      break;
+    _shiftRegisters[block * bytesPerBlock + _shiftHead[block]] = (word >> (HostSimMBI5034::SIM_DATA_SHIFT + 8*lane)) & 0xff;
+    if(++_shiftHead[block] >= bytesPerBlock)
+      _shiftHead[block] = 0;
+  }
+}
+
+// Clocks to shift out one row, with each group of parallel blocks in turn
+static uint32_t RowClocks()
+{
+  return MBI5034ParallelLayout::GetRowClocks(_bytesToSend, _blocks, _parallelBlocks);
+}
+
+// Copy the shift registers of every block to the outputs for a row. The first
+// bit clocked in has been shifted all the way along to the far end of the chain.
+static void Latch(byte *latched)
+{
+  uint16_t bytesPerBlock = _bytesToSend / _blocks;
+  for(uint8_t block = 0; block < _blocks; block++)
+  {
+    const byte *ring = _shiftRegisters + block * bytesPerBlock;
+    for(uint16_t n = 0; n < bytesPerBlock; n++)
+      *latched++ = ring[(_shiftHead[block] + n) % bytesPerBlock];
+  }
+}
+
+
+void HostSimMBI5034::Initialise(byte *frameBuffers, uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, uint8_t blocks, const MBI5034PinMap *pins)
+{
+  _pinsValid = !pins || !pins->Validate();
+  _frameBuffers = frameBuffers;
+  _pendingFrameBuffers = 0;
+  _pendingBrightness = 0;
+  _controlWrites = 0;
+  _skippedRows = 0;
+#if HHLED_REFRESH_STATS
+  _stats = MBI5034RefreshStats();
+#endif
+  _dimming = 256;
+  _pendingDimming = -1;
+  _frameWords = 0;
+  _occupancy = 0;
+  _pendingFrameWords = 0;
+  _colourDepth = colourDepth;
+  _planes = planes;
+  _bytesToSend = bytesToSend;
+  _blocks = blocks;
+  _running = false;
+  _step = 0;
+  _bank = 0;
+  _depth = 0;
+  _frameCount = 0;
+  _lastWaitedFrame = 0;
+
+  delete[] _shiftRegisters;
+  delete[] _latchedData;
+  delete[] _shiftHead;
+  delete[] _rowWords;
+  _shiftRegisters = new byte[_bytesToSend]();
+  _latchedData = new byte[(uint32_t)_colourDepth * _planes * _bytesToSend]();
+  _shiftHead = new uint16_t[_blocks]();
+  _rowWords = new uint32_t[_bytesToSend]();
+
+  _schedule.Compute(_colourDepth, _planes, SIM_REFRESH_INTERVAL_uS * SIM_TICKS_PER_uS, RowClocks() * SIM_SHIFT_TICKS_PER_CLOCK, _maxBitWeight);
+  _time = 0;
+  _frameStart = 0;
+  _frameTicks = 0;
+  memset(_onTime, 0, sizeof(_onTime));
+}
+
+void HostSimMBI5034::SetBrightness(uint16_t brighnessPercent)
+{
+  // Only written between refresh cycles once running, as on the ESP32
+  if(_running)
+  {
+    _pendingBrightness = brighnessPercent;
+  }
+  else
+  {
+    _brightness = brighnessPercent;
+    _controlWrites++;
+  }
+}
+
+void HostSimMBI5034::SetDimming(uint8_t level)
+{
+  _dimming = level == 255 ? 256 : level;
+}
+
+void HostSimMBI5034::StartDisplay()
+{
+  _running = _pinsValid;
+}
+
+void HostSimMBI5034::PresentFrame(byte *frameBuffers, uint32_t *frameWords, const uint8_t *occupancy, int16_t dimming)
+{
+  if(_running)
+  {
+    _pendingFrameWords = frameWords;
+    _pendingOccupancy = occupancy;
+    _pendingDimming = dimming;
+    _pendingFrameBuffers = frameBuffers;
+  }
+  else
+  {
+    _frameWords = frameWords;
+    _occupancy = occupancy;
+    _frameBuffers = frameBuffers;
+    if(dimming >= 0)
+      SetDimming(dimming >= 255 ? 255 : dimming);
+  }
+}
+
+void HostSimMBI5034::EncodeOutput(const byte *frameBuffers, uint32_t *frameWords, uint32_t count)
+{
+  // Laid out as ESP32_16xWideMBI5034 does, with each block's lane of 8 data
+  // lines 8 bits above the last
+  MBI5034ParallelLayout::Encode(frameBuffers, frameWords, count, _bytesToSend, _blocks, _parallelBlocks,
+                                [](uint8_t lane, byte data) { return (uint32_t)data << (SIM_DATA_SHIFT + 8*lane); });
+}
+
+bool HostSimMBI5034::FramePending()
+{
+  // Nothing else will finish the cycle, so do it here rather than wait forever
+  if(_pendingFrameBuffers)
+    StepFrame();
+  return _pendingFrameBuffers != 0;
+}
+
+uint32_t HostSimMBI5034::GetFrameCount()
+{
+  return _frameCount;
+}
+
+uint32_t HostSimMBI5034::GetRefreshRate()
+{
+  return _frameTicks ? SIM_TICKS_PER_uS * 1000000 / _frameTicks : 0;
+}
+
+bool HostSimMBI5034::WaitForFrame(uint32_t timeoutMs)
+{
+  if(_frameCount == _lastWaitedFrame && timeoutMs && _running)
+    StepFrame();
+
+  if(_frameCount == _lastWaitedFrame)
+    return false;
+  _lastWaitedFrame = _frameCount;
+  return true;
+}
+
+void HostSimMBI5034::StepRow()
+{
+  if(!_running)
+    return;
+
+  // Same sequence as the ESP32 refresh interrupt
+  if (++_step >= _schedule.GetStepCount()) 
+  {
+    _step = 0;
+
+    // Whole refresh cycle done, so safe to change the brightness
+    if(_pendingBrightness)
+    {
+      _brightness = _pendingBrightness;
+      _pendingBrightness = 0;
+      _controlWrites++;
+    }
+
+    // and switch to any new frame
+    if(_pendingFrameBuffers)
+    {
+      _frameWords = _pendingFrameWords;
+      _occupancy = _pendingOccupancy;
+      _frameBuffers = _pendingFrameBuffers;
+      _pendingFrameBuffers = 0;
+      if(_pendingDimming >= 0)
+        SetDimming(_pendingDimming >= 255 ? 255 : _pendingDimming);
+      _pendingDimming = -1;
+    }
+    _frameTicks = _time - _frameStart;
+    _frameStart = _time;
+    _frameCount++;
+  }
+  _bank = _schedule.GetStep(_step).bank;
+  _depth = _schedule.GetStep(_step).depth;
+
+  // Nothing lit on this row, so the outputs are left off rather than shift it out
+  uint32_t offset = (_bank + _depth*_planes)*_bytesToSend;
+  uint32_t busy = 0;   // Simulated time taken by the refresh interrupt
+  if(_occupancy && !(_occupancy[_bank] & (1 << _depth)))
+  {
+    // Nothing is latched, the chips keep whatever they last had for the row
+    _skippedRows++;
+  }
+  else
+  {
+    // Clock out the row, each group of blocks in turn, from the words if there are any
+    uint16_t bytesPerBlock = _bytesToSend / _blocks;
+    uint32_t clocks = RowClocks();
+    if(!_frameWords)
+      EncodeOutput(_frameBuffers + offset, _rowWords, _bytesToSend);
+    const uint32_t *w = _frameWords ? _frameWords + offset : _rowWords;
+    for(uint32_t n = 0; n < clocks; n++)
+      ClockIn(n / bytesPerBlock, w[n]);
+    Latch(_latchedData + offset);
+    busy = clocks * SIM_SHIFT_TICKS_PER_CLOCK;
+
+    // Then shown for the on-time of the step, or just part of it when dimmed (none at all
+    // when that is under a tick, as the drivers leave the row dark)
+    _onTime[_depth] += _schedule.GetStepTicks(_step) * _dimming >> 8;
+  }
+
+#if HHLED_REFRESH_STATS
+  _stats.Record(_time * SIM_CYCLES_PER_TICK, (_time + busy) * SIM_CYCLES_PER_TICK,
+                RowClocks() * SIM_SHIFT_TICKS_PER_CLOCK * SIM_CYCLES_PER_TICK);
+#endif
+  _time += busy + _schedule.GetStepTicks(_step);
+}
+
+void HostSimMBI5034::SetMaxBitWeight(uint8_t maxWeight)
+{
+  _maxBitWeight = maxWeight;
+  _step = 0;
+  _schedule.Compute(_colourDepth, _planes, SIM_REFRESH_INTERVAL_uS * SIM_TICKS_PER_uS, RowClocks() * SIM_SHIFT_TICKS_PER_CLOCK, _maxBitWeight);
+}
+
+void HostSimMBI5034::SetParallelBlocks(uint8_t blocks)
+{
+  _parallelBlocks = blocks < 1 ? 1 : blocks > 4 ? 4 : blocks;
+}
+
+const MBI5034Schedule &HostSimMBI5034::GetSchedule()
+{
+  return _schedule;
+}
+
+void HostSimMBI5034::StepFrame()
+{
+  if(!_running)
+    return;
+
+  uint32_t frame = _frameCount;
+  while(frame == _frameCount)
+    StepRow();
+}
+
+bool HostSimMBI5034::IsRunning()
+{
+  return _running;
+}
+
+uint16_t HostSimMBI5034::GetBrightness()
+{
+  return _brightness;
+}
+
+uint32_t HostSimMBI5034::GetControlWrites()
+{
+  return _controlWrites;
+}
+
+const byte *HostSimMBI5034::GetFrameBuffers()
+{
+  return _frameBuffers;
+}
+
+const byte *HostSimMBI5034::GetLatchedData()
+{
+  return _latchedData;
+}
+
+uint64_t HostSimMBI5034::GetTime()
+{
+  return _time;
+}
+
+uint64_t HostSimMBI5034::GetOnTime(uint8_t depth)
+{
+  return _onTime[depth];
+}
+
+uint32_t HostSimMBI5034::GetSkippedRows()
+{
+  return _skippedRows;
+}
+
+#if HHLED_REFRESH_STATS
+void HostSimMBI5034::GetRefreshStats(MBI5034RefreshStats &stats)
+{
+  stats = _stats;
+  stats.refreshRate = GetRefreshRate();
+}
+
+void HostSimMBI5034::ResetRefreshStats()
+{
+  _stats = MBI5034RefreshStats();
+}
+#endif
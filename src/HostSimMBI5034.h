@@ -0,0 +1,143 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class is a simulated platform driver with the same interface as the ESP32
+drivers, so the drawing and encoding code can be built and run on a host
+computer, e.g. Linux, without any hardware.
+
+Nothing is refreshed in the background. Instead the refresh is stepped
+explicitly, one row (one bank at one colour depth) or one whole refresh cycle
+at a time, so anything using it behaves the same on every run.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "MBI5034Schedule.h"
+#include "MBI5034RefreshStats.h"
+#include "MBI5034PinMap.h"
+#include "MBI5034RefreshCost.h"
+#include "MBI5034ParallelLayout.h"
+
+class HostSimMBI5034
+{
+public:
+  // Any pins given are only checked, and if they aren't valid the display never starts
+  static void Initialise(byte *frameBuffers, uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, uint8_t blocks = 1, const MBI5034PinMap *pins = 0);
+  
+  static void SetBrightness(uint16_t brighnessPercent);
+
+  // Only enable the outputs for part of each on-time, 0 (off) to 255 (fully on)
+  static void SetDimming(uint8_t level);
+
+  // Start showing the display
+  static void StartDisplay();
+
+  // Switch to showing a different frame buffer at the end of the current refresh cycle,
+  // optionally refreshing from the GPIO words already translated by EncodeOutput,
+  // and skipping rows with nothing lit according to occupancy. Any dimming given
+  // (0 to 255, as SetDimming) is switched to at the same point.
+  static void PresentFrame(byte *frameBuffers, uint32_t *frameWords = 0, const uint8_t *occupancy = 0, int16_t dimming = -1);
+
+  // Translate count frame buffer bytes into the simulated GPIO words for each clock
+  static void EncodeOutput(const byte *frameBuffers, uint32_t *frameWords, uint32_t count);
+
+  // True until the refresh has switched to the frame last presented
+  static bool FramePending();
+
+  // Number of whole refresh cycles (all planes at all colour depths) completed
+  static uint32_t GetFrameCount();
+
+  // Whole refresh cycles per second, as timed by the simulation over the last one
+  static uint32_t GetRefreshRate();
+
+#if HHLED_REFRESH_STATS
+  // Timing of the simulated refresh interrupt since the last reset, taking the
+  // simulated time to shift out each row to be the time spent in it
+  static void GetRefreshStats(MBI5034RefreshStats &stats);
+  static void ResetRefreshStats();
+#endif
+
+  // Wait for a refresh cycle to complete since the last call. As nothing else
+  // is refreshing the display, if one hasn't this steps a whole cycle itself,
+  // unless timeoutMs is 0 to just poll.
+  static bool WaitForFrame(uint32_t timeoutMs = UINT32_MAX);
+
+  // What refreshing a configuration costs with the simulated timing, with the
+  // blocks clocked out one after another and no bits split up
+  static constexpr MBI5034RefreshCost GetRefreshCost(uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, uint8_t blocks)
+  {
+    return MBI5034RefreshCost(colourDepth, planes, bytesToSend, SIM_REFRESH_INTERVAL_uS,
+                              SIM_TICKS_PER_uS, SIM_SHIFT_TICKS_PER_CLOCK * 1000 / SIM_TICKS_PER_uS);
+  }
+
+  // Simulate the refresh interrupt once, i.e. show the next row
+  static void StepRow();
+
+  // Simulate refreshing up to the end of the current refresh cycle
+  static void StepFrame();
+
+  // Current state of the refresh
+  static bool IsRunning();
+  static uint16_t GetBrightness();
+  static uint32_t GetControlWrites();   // Times the brightness has been written to the chips
+  static const byte *GetFrameBuffers();
+
+  // What the chips were last given to show for each bank at each colour depth,
+  // arranged the same as the frame buffers. Each row is rebuilt by clocking the
+  // GPIO words written out through a model of the chained shift registers of
+  // each block, then latching them, so it should always match what was drawn,
+  // apart from rows skipped, which keep whatever was last latched for them.
+  static const byte *GetLatchedData();
+
+  // Rows not shifted out as nothing was lit on them, these aren't latched and
+  // are left dark, adding nothing to the on-time of their bit
+  static uint32_t GetSkippedRows();
+
+  // Split up bits weighing more than maxWeight, as REFRESH_MAX_BIT_WEIGHT does
+  // for the ESP32 drivers, 0 to show each bit in one go. Starts a new cycle.
+  static void SetMaxBitWeight(uint8_t maxWeight);
+
+  // Clock this many blocks out together, each on its own 8 data lines, as
+  // ESP32_16xWideMBI5034 does with 2, rather than one after another. Only 1 (the
+  // default), 2 or 4. Call before Initialise, i.e. before creating the panel.
+  static void SetParallelBlocks(uint8_t blocks);
+
+  // The schedule of rows being followed
+  static const MBI5034Schedule &GetSchedule();
+
+  // Simulated time in timer ticks, and the total time the outputs have been
+  // enabled for each bit (0 = top bit), to check the bit weights
+  static uint64_t GetTime();
+  static uint64_t GetOnTime(uint8_t depth);
+
+  // Simulated timing, the same as the ESP32 defaults
+  static const uint32_t SIM_TICKS_PER_uS = 10;
+  static const uint32_t SIM_REFRESH_INTERVAL_uS = 6000;
+  static const uint32_t SIM_SHIFT_TICKS_PER_CLOCK = 1;
+  static const uint32_t SIM_CYCLES_PER_TICK = 24;   // i.e. a 240MHz CPU
+
+  // Position of the 8 data lines in the simulated GPIO words, with those for
+  // each further block clocked out in parallel 8 bits above the last
+  static const uint8_t SIM_DATA_SHIFT = 0;
+};
@@ -0,0 +1,185 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class generates the whole refresh cycle for a chain of MBI5034 panels as
+a stream of parallel output samples, ready to be sent out repeatedly by DMA.
+******************************************************************************/
+#include "MBI5034Bitstream.h"
+
+MBI5034Bitstream::MBI5034Bitstream(uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, uint8_t blocks, uint16_t lsbSamples)
+  : _colourDepth(colourDepth), _planes(planes), _bytesToSend(bytesToSend),
+    _blocks(blocks > MAX_BLOCKS ? MAX_BLOCKS : blocks), _lsbSamples(lsbSamples)
+{
+}
+
+uint32_t MBI5034Bitstream::GetOnSamples(uint8_t depth) const
+{
+  return (uint32_t)_lsbSamples << (_colourDepth - depth - 1);
+}
+
+uint32_t MBI5034Bitstream::GetRowSamples(uint8_t depth) const
+{
+  // Two samples per clock, then latch, then show
+  return 2 * (uint32_t)_bytesToSend + LATCH_SAMPLES + GetOnSamples(depth);
+}
+
+uint32_t MBI5034Bitstream::GetSampleCount() const
+{
+  return RowStart(_colourDepth, 0);
+}
+
+// Rows are in the same order as the refresh interrupt shows them, all the
+// banks of the top bit first
+uint32_t MBI5034Bitstream::RowStart(uint8_t depth, uint8_t bank) const
+{
+  uint32_t start = 0;
+  for(uint8_t d = 0; d < depth; d++)
+    start += _planes * GetRowSamples(d);
+  return start + bank * GetRowSamples(depth);
+}
+
+void MBI5034Bitstream::Generate(const byte *frameBuffers, uint16_t *samples) const
+{
+  for(uint8_t depth = 0; depth < _colourDepth; depth++)
+    for(uint8_t bank = 0; bank < _planes; bank++)
+      GenerateRow(frameBuffers, samples, depth, bank);
+}
+
+void MBI5034Bitstream::GenerateRow(const byte *frameBuffers, uint16_t *samples, uint8_t depth, uint8_t bank) const
+{
+  const byte *f = frameBuffers + (bank + depth*_planes)*_bytesToSend;
+  uint16_t *s = samples + RowStart(depth, bank);
+  uint16_t addr = ((bank & 1) ? SAMPLE_A0 : 0) | ((bank & 2) ? SAMPLE_A1 : 0);
+
+  // Shift the row out with the display blanked, each block with its own clock
+  uint16_t bytesPerBlock = _bytesToSend / _blocks;
+  for(uint8_t block = 0; block < _blocks; block++)
+  {
+    uint16_t clk = SAMPLE_CLK0 << block;
+    for(uint16_t n = 0; n < bytesPerBlock; n++)
+    {
+      uint16_t data = *f++ | addr | SAMPLE_OE;
+      *s++ = data;
+      *s++ = data | clk;
+    }
+  }
+
+  // Latch it
+  *s++ = addr | SAMPLE_OE;
+  *s++ = addr | SAMPLE_OE | SAMPLE_LAT;
+  *s++ = addr | SAMPLE_OE;
+
+  // Then show it for the time of this bit
+  for(uint32_t n = GetOnSamples(depth); n; n--)
+    *s++ = addr;
+}
+
+uint16_t MBI5034Bitstream::BuildDescriptors(MBI5034DmaDescriptor *descriptors, uint16_t maxDescriptors, uint16_t maxSamples) const
+{
+  uint32_t total = GetSampleCount();
+  uint16_t count = (total + maxSamples - 1) / maxSamples;
+
+  for(uint16_t i = 0; i < count && i < maxDescriptors; i++)
+  {
+    descriptors[i].offset = (uint32_t)i * maxSamples;
+    descriptors[i].length = (i == count - 1) ? total - descriptors[i].offset : maxSamples;
+    descriptors[i].next = (i + 1 == count) ? 0 : i + 1;
+  }
+  return count;
+}
+
+bool MBI5034Bitstream::Decode(const uint16_t *samples, uint32_t count, byte *frameBuffers) const
+{
+  uint16_t bytesPerBlock = _bytesToSend / _blocks;
+  byte *shiftRegisters = new byte[_bytesToSend]();   // Ring for each block, as in HostSimMBI5034
+  uint16_t heads[MAX_BLOCKS] = {0};
+  byte *latched = new byte[_bytesToSend]();
+  uint32_t *onTime = new uint32_t[(uint32_t)_planes * _bytesToSend * 8]();  // [bank][led][line]
+  uint8_t bank = 0;
+  uint32_t on = 0;
+  uint16_t previous = SAMPLE_OE;
+
+  for(uint32_t i = 0; i <= count; i++)
+  {
+    // An extra latch at the end to account for the last row shown
+    uint16_t s = i < count ? samples[i] : (previous | SAMPLE_LAT);
+    uint16_t rising = s & ~previous;
+
+    for(uint8_t block = 0; block < _blocks; block++)
+    {
+      if(rising & (SAMPLE_CLK0 << block))
+      {
+        shiftRegisters[block * bytesPerBlock + heads[block]] = s & SAMPLE_DATA;
+        if(++heads[block] >= bytesPerBlock)
+          heads[block] = 0;
+      }
+    }
+
+    if(rising & SAMPLE_LAT)
+    {
+      // Add up how long the row that was latched has been shown for
+      for(uint16_t n = 0; n < _bytesToSend; n++)
+        for(uint8_t line = 0; line < 8; line++)
+          if(latched[n] & (1 << line))
+            onTime[(bank * _bytesToSend + n) * 8 + line] += on;
+      on = 0;
+
+      // First bit clocked in is at the far end of the chain
+      for(uint8_t block = 0; block < _blocks; block++)
+        for(uint16_t n = 0; n < bytesPerBlock; n++)
+          latched[block * bytesPerBlock + n] = shiftRegisters[block * bytesPerBlock + (heads[block] + n) % bytesPerBlock];
+      bank = ((s & SAMPLE_A0) ? 1 : 0) | ((s & SAMPLE_A1) ? 2 : 0);
+    }
+
+    if(!(s & SAMPLE_OE))
+      on++;
+    previous = s;
+  }
+
+  // Each LED's on-time should be a sum of bit on-times, which gives its bits
+  bool ok = true;
+  memset(frameBuffers, 0, (uint32_t)_colourDepth * _planes * _bytesToSend);
+  for(uint8_t b = 0; b < _planes; b++)
+  {
+    for(uint16_t n = 0; n < _bytesToSend; n++)
+    {
+      for(uint8_t line = 0; line < 8; line++)
+      {
+        uint32_t t = onTime[(b * _bytesToSend + n) * 8 + line];
+        if(t % _lsbSamples || t / _lsbSamples >= (1u << _colourDepth))
+          ok = false;
+        uint32_t value = t / _lsbSamples;
+        for(uint8_t depth = 0; depth < _colourDepth; depth++)
+          if(value & (1 << (_colourDepth - depth - 1)))
+            frameBuffers[(b + depth*_planes)*_bytesToSend + n] |= 1 << line;
+      }
+    }
+  }
+
+  delete[] onTime;
+  delete[] latched;
+  delete[] shiftRegisters;
+  return ok;
+}
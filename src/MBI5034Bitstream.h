@@ -0,0 +1,103 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class generates the whole refresh cycle for a chain of MBI5034 panels as
+a stream of parallel output samples, ready to be sent out repeatedly by DMA,
+e.g. by the ESP32 I2S or LCD peripheral in parallel mode, rather than driving
+every clock edge from the refresh interrupt.
+
+Each 16-bit sample is the state of all the lines at one tick of the sample
+clock: the 8 data lines, the address, LAT, OE and the CLK line of each block.
+Each bit takes 2 samples, with the block's CLK low then high, and after each
+row is shifted out it is latched and shown for a number of samples depending
+on its colour depth, so the on-time of each bit is set by the stream itself.
+
+It doesn't depend on any hardware, so a stream can be checked on a host
+computer by decoding it again through a model of the chips with Decode().
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+
+// A piece of the sample stream, within the limit of one DMA descriptor
+struct MBI5034DmaDescriptor
+{
+  uint32_t offset;    // First sample
+  uint16_t length;    // Number of samples
+  uint16_t next;      // Index of the descriptor to follow, the chain loops back to the start
+};
+
+class MBI5034Bitstream
+{
+public:
+  // Position of each line in the samples
+  static const uint16_t SAMPLE_DATA = 0x00ff;   // D1-D8
+  static const uint16_t SAMPLE_A0 = 0x0100;
+  static const uint16_t SAMPLE_A1 = 0x0200;
+  static const uint16_t SAMPLE_LAT = 0x0400;
+  static const uint16_t SAMPLE_OE = 0x0800;     // Active low, i.e. set to blank the display
+  static const uint16_t SAMPLE_CLK0 = 0x1000;   // Then CLK1-CLK3 for each further block
+  static const uint8_t MAX_BLOCKS = 4;
+
+  // ESP32 DMA descriptors hold up to 4092 bytes
+  static const uint16_t MAX_DESCRIPTOR_SAMPLES = 4092 / sizeof(uint16_t);
+
+  // Same layout as the platform drivers are given, plus the number of samples
+  // the least significant bit is shown for, each more significant bit doubling it
+  MBI5034Bitstream(uint8_t colourDepth, uint8_t planes, uint16_t bytesToSend, uint8_t blocks, uint16_t lsbSamples);
+
+  // Total samples in one refresh cycle
+  uint32_t GetSampleCount() const;
+
+  // Samples in each row and how many of them are shown, for the given depth (0 = top bit)
+  uint32_t GetRowSamples(uint8_t depth) const;
+  uint32_t GetOnSamples(uint8_t depth) const;
+
+  // Fill samples (GetSampleCount() of them) with one refresh cycle of the frame buffers
+  void Generate(const byte *frameBuffers, uint16_t *samples) const;
+
+  // Regenerate just the row for one bank at one colour depth, e.g. after drawing on it
+  void GenerateRow(const byte *frameBuffers, uint16_t *samples, uint8_t depth, uint8_t bank) const;
+
+  // Split the stream into a looping chain of descriptors of up to maxSamples each.
+  // Returns the number of descriptors needed, only filling in up to maxDescriptors.
+  uint16_t BuildDescriptors(MBI5034DmaDescriptor *descriptors, uint16_t maxDescriptors, uint16_t maxSamples = MAX_DESCRIPTOR_SAMPLES) const;
+
+  // Rebuild the frame buffers from one refresh cycle of samples by clocking them
+  // through a model of the shift registers, latches and outputs of the chips,
+  // timing how long each LED is on. Returns false if any LED was on for a time
+  // that isn't a combination of the bit on-times, i.e. the stream is wrong.
+  bool Decode(const uint16_t *samples, uint32_t count, byte *frameBuffers) const;
+
+private:
+  static const uint8_t LATCH_SAMPLES = 3;
+
+  uint32_t RowStart(uint8_t depth, uint8_t bank) const;
+
+  uint8_t _colourDepth;
+  uint8_t _planes;
+  uint16_t _bytesToSend;
+  uint8_t _blocks;
+  uint16_t _lsbSamples;
+};
@@ -0,0 +1,71 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+This class has the layout of the GPIO words clocked out for each row when
+several blocks of panels share a clock line and are shifted out together,
+each block on its own set of 8 data lines (a lane), as ESP32_16xWideMBI5034
+does with pairs of blocks and HostSimMBI5034 can simulate.
+
+The blocks are taken a group of lanes at a time, and each group is clocked
+out in turn, one word per byte of a block. Each word carries the byte for
+that clock from every block of the group, mapped onto the lane's data lines
+by the driver, so a row takes only as many clocks as one block per group.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+
+class MBI5034ParallelLayout
+{
+public:
+  // Clocks to shift out a row of bytesToSend over all blocks, lanes blocks at a time
+  static constexpr uint32_t GetRowClocks(uint16_t bytesToSend, uint8_t blocks, uint8_t lanes)
+  {
+    return (uint32_t)(blocks + lanes - 1) / lanes * (bytesToSend / blocks);
+  }
+
+  // Translate count frame buffer bytes, made up of whole rows of bytesToSend,
+  // into the word for each clock. map(lane, data) gives the GPIO bits for a
+  // byte on a lane's data lines. Only the first GetRowClocks words of each row
+  // are written, the rest are left as they are.
+  template<class MAP> static void Encode(const byte *frameBuffers, uint32_t *frameWords, uint32_t count,
+                                         uint16_t bytesToSend, uint8_t blocks, uint8_t lanes, MAP map)
+  {
+    uint16_t bytesPerBlock = bytesToSend / blocks;
+    for(uint32_t row = 0; row < count; row += bytesToSend)
+    {
+      uint32_t *w = frameWords + row;
+      for(uint8_t block = 0; block < blocks; block += lanes)
+      {
+        const byte *f = frameBuffers + row + block * bytesPerBlock;
+        for(uint16_t n = 0; n < bytesPerBlock; n++)
+        {
+          uint32_t word = 0;
+          for(uint8_t lane = 0; lane < lanes && block + lane < blocks; lane++)
+            word |= map(lane, f[n + lane * bytesPerBlock]);
+          *w++ = word;
+        }
+      }
+    }
+  }
+};
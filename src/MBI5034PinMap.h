@@ -0,0 +1,166 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+The GPIO pins a set of panels is wired to, so that one firmware image can drive
+boards wired differently, picking the pins at run time. Passed to the platform
+driver's Initialise, which builds the lookup tables translating frame buffer
+bytes into GPIO words from it, rather than them being fixed at compile time by
+ESP32_4xMBI5034_Pins.h. Leaving it out uses the pins in that file as before.
+
+Data lines are in frame buffer bit order, D1 being bit 0 of each byte, with a
+second set of 8 for drivers clocking two blocks out at once. They may be on
+any output pin, those above 31 being written through the second GPIO output
+register. The address and control lines must be on pins 0-31.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+
+struct MBI5034PinMap
+{
+  static const uint8_t MAX_DATA_LINES = 16;
+  static const uint8_t MAX_CLOCKS = 4;
+  static const uint8_t MAX_PINS = MAX_DATA_LINES + MAX_CLOCKS + 4;
+
+  uint8_t data[MAX_DATA_LINES];   // D1 upwards
+  uint8_t dataLines;              // Number of data lines used, 8 or 16
+  uint8_t a0;
+  uint8_t a1;
+  uint8_t clk[MAX_CLOCKS];        // One for each block, or pair of blocks, clocked separately
+  uint8_t clocks;                 // Number of clock lines used
+  uint8_t lat;
+  uint8_t oe;
+
+  // GPIOs 0-33 the ESP32 can drive, excluding those wired to the SPI flash
+  static bool IsOutputPin(uint8_t pin)
+  {
+    return pin < 34 && (pin < 6 || pin > 11) && pin != 20 && pin != 24 && (pin < 28 || pin > 31);
+  }
+
+  // Check the pins can be used as they are, returning a description of the first
+  // problem found, or 0 if there isn't one. The address lines may share data
+  // lines, as the address is only set once a row has been shifted out, but not
+  // each other or a control line. Nothing else may share a pin.
+  const char *Validate() const
+  {
+    if(dataLines != 8 && dataLines != 16)
+      return "Only 8 or 16 data lines are supported";
+    if(clocks < 1 || clocks > MAX_CLOCKS)
+      return "Between 1 and 4 clock lines are supported";
+
+    uint64_t used = 0;
+    for(uint8_t n = 0; n < dataLines; n++)
+    {
+      if(!IsOutputPin(data[n]))
+        return "Data line is not an output pin";
+      if(used & (1ULL << data[n]))
+        return "Data lines share a pin";
+      used |= 1ULL << data[n];
+    }
+
+    if(!IsOutputPin(a0) || !IsOutputPin(a1) || a0 > 31 || a1 > 31)
+      return "Address lines must be output pins 0-31";
+    if(a0 == a1)
+      return "A0 and A1 share a pin";
+    uint64_t address = (1ULL << a0) | (1ULL << a1);
+
+    uint8_t control[MAX_CLOCKS + 2] = { lat, oe };
+    for(uint8_t n = 0; n < clocks; n++)
+      control[n + 2] = clk[n];
+    for(uint8_t n = 0; n < clocks + 2; n++)
+    {
+      if(!IsOutputPin(control[n]) || control[n] > 31)
+        return "CLK, LAT and OE must be output pins 0-31";
+      if((used | address) & (1ULL << control[n]))
+        return "CLK, LAT or OE shares a pin with another line";
+      used |= 1ULL << control[n];
+    }
+    return 0;
+  }
+
+  // Lookup table of the GPIO bits to set for each value of a frame buffer byte,
+  // for the 8 data lines from firstLine. Bits for pins above 31 go in out1.
+  void BuildMapping(uint32_t *out, uint32_t *out1, uint8_t firstLine = 0) const
+  {
+    for(uint16_t value = 0; value < 256; value++)
+    {
+      uint64_t bits = 0;
+      for(uint8_t bit = 0; bit < 8; bit++)
+        if(value & (1 << bit))
+          bits |= 1ULL << data[firstLine + bit];
+      out[value] = (uint32_t)bits;
+      if(out1)
+        out1[value] = (uint32_t)(bits >> 32);
+    }
+  }
+
+  // All the data lines, in GPIO.out and GPIO.out1
+  uint32_t GetDataBits() const
+  {
+    return (uint32_t)GetAllDataBits();
+  }
+  uint32_t GetDataBits1() const
+  {
+    return (uint32_t)(GetAllDataBits() >> 32);
+  }
+
+  // Every pin used, to set them up as outputs, returning how many there are.
+  // Any address lines sharing data lines appear twice.
+  uint8_t GetPins(uint8_t pins[MAX_PINS]) const
+  {
+    uint8_t count = 0;
+    for(uint8_t n = 0; n < dataLines; n++)
+      pins[count++] = data[n];
+    for(uint8_t n = 0; n < clocks; n++)
+      pins[count++] = clk[n];
+    pins[count++] = a0;
+    pins[count++] = a1;
+    pins[count++] = lat;
+    pins[count++] = oe;
+    return count;
+  }
+
+  // Address lines to set to select an address plane
+  uint32_t GetAddressBits(uint8_t bank) const
+  {
+    return ((bank & 1) ? (1UL << a0) : 0) | ((bank & 2) ? (1UL << a1) : 0);
+  }
+
+  uint32_t GetClockBits() const
+  {
+    uint32_t bits = 0;
+    for(uint8_t n = 0; n < clocks; n++)
+      bits |= 1UL << clk[n];
+    return bits;
+  }
+
+private:
+  uint64_t GetAllDataBits() const
+  {
+    uint64_t bits = 0;
+    for(uint8_t n = 0; n < dataLines; n++)
+      bits |= 1ULL << data[n];
+    return bits;
+  }
+};
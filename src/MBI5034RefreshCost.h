@@ -0,0 +1,174 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/******************************************************************************
+This class models what it costs to refresh a set of panels, worked out at
+compile time from the same figures the platform drivers use, so a colour
+depth, panel count and refresh interval can be checked before ever reaching
+the hardware.
+
+The rows are laid out as MBI5034Schedule does, and each one costs the GPIO
+writes the ESP32 drivers make for it: two per clock (the data with the clock
+low, then the clock high), or three with data lines above GPIO 31, plus six
+to disable the outputs, drop the clock, set the address, pulse the latch and
+enable the outputs again.
+
+The schedule shares out the refresh interval assuming each row takes a fixed
+time to shift out. The on-time of each row is timed from when it has been
+shifted out, so if the GPIO writes are really slower than that the refresh
+cycle just takes longer. Given how fast writes actually go, the real refresh
+rate and the share of the CPU spent shifting out rows can be found too.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "MBI5034Schedule.h"
+
+class MBI5034RefreshCost
+{
+public:
+  static const uint32_t WRITES_PER_CLOCK = 2;
+  static const uint32_t WRITES_PER_CLOCK_HIGH_DATA = 3;   // Data lines above GPIO 31 too
+  static const uint32_t WRITES_PER_ROW = 6;               // Besides those for each clock
+
+  // colourDepth bits of planes address planes, each row taking clocksPerRow
+  // clocks, refreshed over intervalUs with a timer running at ticksPerUs and
+  // each clock taken as shiftNsPerClock to shift out, bits weighing more than
+  // maxWeight split up (see MBI5034Schedule::Compute)
+  constexpr MBI5034RefreshCost(uint8_t colourDepth, uint8_t planes, uint32_t clocksPerRow, uint32_t intervalUs,
+                               uint32_t ticksPerUs, uint32_t shiftNsPerClock, uint8_t maxWeight = 0, bool highDataLines = false)
+    : _rows(planes * Chunks(colourDepth - 1, TopChunk(colourDepth, maxWeight))),
+      _weights((uint32_t)planes * ((1u << colourDepth) - 1)),
+      _writesPerRow(clocksPerRow * (highDataLines ? WRITES_PER_CLOCK_HIGH_DATA : WRITES_PER_CLOCK) + WRITES_PER_ROW),
+      _ticksPerUs(ticksPerUs),
+      _intervalTicks(intervalUs * ticksPerUs),
+      _shiftTicks(clocksPerRow * shiftNsPerClock * ticksPerUs / 1000)
+  {
+  }
+
+  // Rows shifted out per refresh cycle
+  constexpr uint32_t GetRowsPerFrame() const
+  {
+    return _rows;
+  }
+
+  constexpr uint32_t GetWritesPerRow() const
+  {
+    return _writesPerRow;
+  }
+
+  constexpr uint64_t GetWritesPerFrame() const
+  {
+    return (uint64_t)_rows * _writesPerRow;
+  }
+
+  // True if every row can be shifted out within the refresh interval and still
+  // leave the least significant bit its shortest on-time
+  constexpr bool MeetsTarget() const
+  {
+    return _intervalTicks > GetShiftingTicks() && (_intervalTicks - GetShiftingTicks()) / _weights >= MBI5034Schedule::MIN_LSB_TICKS;
+  }
+
+  // On-time of the least significant bit, as the schedule will set it
+  constexpr uint32_t GetLsbTicks() const
+  {
+    return MeetsTarget() ? (_intervalTicks - GetShiftingTicks()) / _weights : MBI5034Schedule::MIN_LSB_TICKS;
+  }
+
+  // Time the refresh cycle is scheduled to take, longer than the interval if it doesn't meet it
+  constexpr uint32_t GetFrameTicks() const
+  {
+    return GetShiftingTicks() + _weights * GetLsbTicks();
+  }
+
+  constexpr uint32_t GetRefreshRate() const
+  {
+    return _ticksPerUs * 1000000 / GetFrameTicks();
+  }
+
+  constexpr uint64_t GetWritesPerSecond() const
+  {
+    return GetWritesPerFrame() * _ticksPerUs * 1000000 / GetFrameTicks();
+  }
+
+  // With GPIO writes really taking place at busWritesPerSecond, the time the
+  // refresh interrupt spends shifting out a row and a whole refresh cycle
+  constexpr uint32_t GetRowNs(uint32_t busWritesPerSecond) const
+  {
+    return (uint64_t)_writesPerRow * 1000000000 / busWritesPerSecond;
+  }
+
+  constexpr uint32_t GetFrameNs(uint32_t busWritesPerSecond) const
+  {
+    return _rows * GetRowNs(busWritesPerSecond) + (uint64_t)_weights * GetLsbTicks() * 1000 / _ticksPerUs;
+  }
+
+  // The refresh rate that really gives
+  constexpr uint32_t GetRefreshRate(uint32_t busWritesPerSecond) const
+  {
+    return 1000000000 / GetFrameNs(busWritesPerSecond);
+  }
+
+  // and the share of the CPU the refresh interrupt takes
+  constexpr uint32_t GetDutyPercent(uint32_t busWritesPerSecond) const
+  {
+    return (uint64_t)_rows * GetRowNs(busWritesPerSecond) * 100 / GetFrameNs(busWritesPerSecond);
+  }
+
+  // Fastest refresh rate possible, with the interval cut right down to give
+  // the least significant bit its shortest on-time
+  constexpr uint32_t GetMaxRefreshRate(uint32_t busWritesPerSecond) const
+  {
+    return 1000000000 / (_rows * GetRowNs(busWritesPerSecond) + (uint64_t)_weights * MBI5034Schedule::MIN_LSB_TICKS * 1000 / _ticksPerUs);
+  }
+
+private:
+  // Weight of each chunk of the top bit, rounded down to a power of two as the schedule does
+  static constexpr uint8_t TopChunk(uint8_t colourDepth, uint8_t maxWeight)
+  {
+    return maxWeight == 0 || maxWeight > (1 << (colourDepth - 1)) ? 1 << (colourDepth - 1) : PowerOfTwoBelow(maxWeight);
+  }
+
+  // Largest power of two no more than n, by clearing the lowest bit set until one is left
+  static constexpr uint8_t PowerOfTwoBelow(uint8_t n)
+  {
+    return n & (n - 1) ? PowerOfTwoBelow(n & (n - 1)) : n;
+  }
+
+  // Chunks each address plane of the bits of weight 2^bit and below are shown in
+  static constexpr uint32_t Chunks(uint8_t bit, uint8_t maxWeight)
+  {
+    return ((1u << bit) < maxWeight ? 1 : (1u << bit) / maxWeight) + (bit ? Chunks(bit - 1, maxWeight) : 0);
+  }
+
+  constexpr uint32_t GetShiftingTicks() const
+  {
+    return _rows * _shiftTicks;
+  }
+
+  uint32_t _rows;
+  uint32_t _weights;
+  uint32_t _writesPerRow;
+  uint32_t _ticksPerUs;
+  uint32_t _intervalTicks;
+  uint32_t _shiftTicks;
+};
@@ -0,0 +1,85 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+Statistics on the refresh interrupt of the platform drivers, to see how much
+of the CPU it takes and whether it keeps up, e.g. when trying out a higher
+colour depth. Times are in CPU cycles.
+
+Collecting them adds a little to every interrupt, so they are only compiled
+in when HHLED_REFRESH_STATS is set to 1, either here or as a build flag.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+
+#ifndef HHLED_REFRESH_STATS
+#define HHLED_REFRESH_STATS 0
+#endif
+
+struct MBI5034RefreshStats
+{
+  static const uint8_t HISTOGRAM_BUCKETS = 16;
+
+  uint32_t interrupts = 0;
+  uint32_t minCycles = UINT32_MAX;
+  uint32_t maxCycles = 0;
+  uint64_t totalCycles = 0;       // Spent in the interrupt
+  uint64_t elapsedCycles = 0;     // Since the first interrupt counted
+  uint32_t histogram[HISTOGRAM_BUCKETS] = {0};  // Interrupts taking 2^n to 2^(n+1)-1 cycles, the last also counting any longer
+  uint32_t overruns = 0;          // Rows taking longer to shift out than the time allowed for them, slowing the refresh
+  uint32_t refreshRate = 0;       // Whole refresh cycles per second, filled in when the stats are read
+  uint32_t lastStart = 0;
+
+  inline uint32_t GetAverageCycles() const
+  {
+    return interrupts ? totalCycles / interrupts : 0;
+  }
+
+  // Share of the CPU taken by the interrupt
+  inline uint32_t GetLoadPercent() const
+  {
+    return elapsedCycles ? totalCycles * 100 / elapsedCycles : 0;
+  }
+
+  // Count one interrupt, from its start and end cycle counts, that was allowed budget
+  // cycles (UINT32_MAX for interrupts the schedule doesn't allow a time for)
+  inline void IRAM_ATTR Record(uint32_t start, uint32_t end, uint32_t budget)
+  {
+    uint32_t cycles = end - start;
+    if(interrupts)
+      elapsedCycles += start - lastStart;
+    lastStart = start;
+    interrupts++;
+    totalCycles += cycles;
+    if(cycles < minCycles)
+      minCycles = cycles;
+    if(cycles > maxCycles)
+      maxCycles = cycles;
+    if(cycles > budget)
+      overruns++;
+
+    uint8_t bucket = cycles ? 31 - __builtin_clz(cycles) : 0;
+    histogram[bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1]++;
+  }
+};
@@ -0,0 +1,206 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2021 Neil Stevenson (Twitter: @mediablip)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/******************************************************************************
+This class works out the binary code modulation timing for a set of panels:
+how long the outputs are enabled for each bit plane so that the whole refresh
+cycle takes a given time.
+
+Every row is shifted out with the outputs disabled, which takes the same time
+whatever the bit, so that time is taken off the refresh cycle first and the
+rest is shared out between the bits, each one shown for exactly twice as long
+as the next. The on-times don't include any of the shift time, so the weights
+stay linear right down to the least significant bit.
+
+The order the rows are shown in is worked out here too, as a list of steps,
+each one row of one bit. Normally each bit is shown in one go, all the address
+planes of the top bit first, then the next bit and so on. With a maximum bit
+weight set, any bit weighing more than that is split into chunks of that
+weight, and the chunks are dealt out over the rounds of the refresh cycle so
+the rounds come out within a chunk of the same length. The top bit then lights
+up once per round rather than once per cycle, so it is seen to flicker at a
+multiple of the refresh rate, at the cost of shifting out the rows of the split
+bits more than once per cycle.
+
+Times are in ticks of whatever timer the platform driver uses.
+******************************************************************************/
+#pragma once
+#include <Arduino.h>
+
+class MBI5034Schedule
+{
+public:
+  // Shortest on-time allowed for the least significant bit
+  static const uint32_t MIN_LSB_TICKS = 1;
+
+  // Up to 6 bits of 4 address planes, if every bit was split right down to weight 1
+  static const uint16_t MAX_STEPS = 4 * 63;
+
+  // One row of one bit, shown for weight times the on-time of the least significant bit
+  struct Step
+  {
+    uint8_t depth;    // 0 = top bit
+    uint8_t bank;
+    uint8_t weight;
+  };
+
+  // Share out a refresh cycle of frameTicks between colourDepth bits of each of
+  // planes address planes, each taking shiftTicks to shift out first. Bits
+  // weighing more than maxWeight are split up, unless it is 0. A maxWeight
+  // that isn't a power of two is taken as the one below it.
+  void Compute(uint8_t colourDepth, uint8_t planes, uint32_t frameTicks, uint32_t shiftTicks, uint8_t maxWeight = 0)
+  {
+    uint8_t topWeight = 1 << (colourDepth - 1);
+    if(maxWeight == 0 || maxWeight > topWeight)
+      maxWeight = topWeight;
+
+    // Only a power of two divides every heavier bit evenly, so round down to one
+    while(maxWeight & (maxWeight - 1))
+      maxWeight &= maxWeight - 1;
+
+    // Each chunk, heaviest first, goes in the round with the least weight so
+    // far, so the top bit is in every round and the rounds come out within a
+    // chunk of each other, spacing the flashes of the top bit out evenly
+    uint8_t rounds = topWeight / maxWeight;
+    uint16_t load[32] = {0};
+    uint8_t due[32][6] = {{0}};
+    for(uint8_t depth = 0; depth < colourDepth; depth++)
+    {
+      uint8_t weight = 1 << (colourDepth - depth - 1);
+      uint8_t chunk = weight < maxWeight ? weight : maxWeight;
+      for(uint8_t n = weight / chunk; n > 0; n--)
+      {
+        uint8_t lightest = 0;
+        for(uint8_t round = 1; round < rounds; round++)
+          if(load[round] < load[lightest])
+            lightest = round;
+        load[lightest] += chunk;
+        due[lightest][depth]++;
+      }
+    }
+
+    // Then each round shows each address plane of the bits due in it, top bit first
+    _stepCount = 0;
+    for(uint8_t round = 0; round < rounds; round++)
+    {
+      for(uint8_t depth = 0; depth < colourDepth; depth++)
+      {
+        uint8_t weight = 1 << (colourDepth - depth - 1);
+        uint8_t chunk = weight < maxWeight ? weight : maxWeight;
+        for(uint8_t n = 0; n < due[round][depth]; n++)
+        {
+          for(uint8_t bank = 0; bank < planes; bank++)
+          {
+            _steps[_stepCount].depth = depth;
+            _steps[_stepCount].bank = bank;
+            _steps[_stepCount].weight = chunk;
+            _stepCount++;
+          }
+        }
+      }
+    }
+    _flashes = rounds;
+
+    _shiftTicks = shiftTicks;
+    uint32_t shifting = _stepCount * shiftTicks;
+    uint32_t weights = (uint32_t)planes * ((1u << colourDepth) - 1);
+    _lsbTicks = frameTicks > shifting ? (frameTicks - shifting) / weights : 0;
+    if(_lsbTicks < MIN_LSB_TICKS)
+      _lsbTicks = MIN_LSB_TICKS;
+
+    for(uint8_t depth = 0; depth < colourDepth; depth++)
+      _onTicks[depth] = _lsbTicks << (colourDepth - depth - 1);
+
+    // Not quite what was asked for if it didn't divide exactly or there wasn't room
+    _frameTicks = shifting + weights * _lsbTicks;
+  }
+
+  // Steps making up one refresh cycle, in order
+  inline uint16_t GetStepCount() const
+  {
+    return _stepCount;
+  }
+
+  inline const Step &GetStep(uint16_t step) const
+  {
+    return _steps[step];
+  }
+
+  // The step under way a given time into the refresh cycle
+  uint16_t GetStepAt(uint32_t ticks) const
+  {
+    uint16_t step = 0;
+    for(uint32_t time = 0; step < _stepCount - 1; step++)
+    {
+      time += _shiftTicks + GetStepTicks(step);
+      if(time > ticks)
+        break;
+    }
+    return step;
+  }
+
+  // Time the outputs are enabled for a step
+  inline uint32_t GetStepTicks(uint16_t step) const
+  {
+    return _lsbTicks * _steps[step].weight;
+  }
+
+  // Total time the outputs are enabled for each row of a bit per refresh cycle, 0 = top bit
+  inline uint32_t GetOnTicks(uint8_t depth) const
+  {
+    return _onTicks[depth];
+  }
+
+  inline uint32_t GetLsbTicks() const
+  {
+    return _lsbTicks;
+  }
+
+  // Time the whole refresh cycle will actually take
+  inline uint32_t GetFrameTicks() const
+  {
+    return _frameTicks;
+  }
+
+  // Refresh rate this gives, for a timer running at ticksPerSecond
+  inline uint32_t GetRefreshRate(uint32_t ticksPerSecond) const
+  {
+    return _frameTicks ? ticksPerSecond / _frameTicks : 0;
+  }
+
+  // Rate the top bit lights up at, i.e. the flicker rate seen
+  inline uint32_t GetVisibleRefreshRate(uint32_t ticksPerSecond) const
+  {
+    return GetRefreshRate(ticksPerSecond) * _flashes;
+  }
+
+private:
+  Step _steps[MAX_STEPS] = {};  // Initialised so static schedules are set up before any constructors run
+  uint16_t _stepCount = 0;
+  uint8_t _flashes = 1;           // Times the top bit is shown per cycle
+  uint32_t _onTicks[6] = {0};
+  uint32_t _lsbTicks = 0;
+  uint32_t _shiftTicks = 0;
+  uint32_t _frameTicks = 0;
+};
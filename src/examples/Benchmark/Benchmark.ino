@@ -0,0 +1,200 @@
+/******************************************************************************
+This is an Arduino sketch to measure the drawing throughput of the HH LED
+panel library, reported as pixels per second on the serial port.
+
+Each test is run twice over the same area: once through drawPixel, which is
+the path every GFX primitive used to take, and once through the native span
+and rectangle paths, so the before and after figures can be compared directly.
+
+The panels are set up as the 240x64 wall (16 panels, rotation 1) as used by
+the Clock, E1.31 and xmas sketches.
+
+It can also be built and run on a host computer against the simulated
+platform, see CMakeLists.txt. The same paths are timed there by HHLedBenchmark
+for both panel arrangements at every colour depth, which is where changes to
+them should be measured; the figures from this sketch on an ESP32 are only a
+check that the host results carry over.
+******************************************************************************/
+
+// Panel type and arrangement
+#include <HHLedPanel_16x64x16_impl.h>
+// Hardware driver, or the simulated one when built on a host computer
+#ifdef HHLED_HOST
+#include <HostSimMBI5034.h>
+typedef HostSimMBI5034 Platform;
+#else
+#include <ESP32_16xMBI5034.h>
+typedef ESP32_16xMBI5034 Platform;
+#endif
+// Adafruit GFX interface
+#include <HHLedPanel.h>
+
+#define MAX_BRIGHTNESS  12  // 12%-200%. At 12% four panels consume around 6 amps, at 100% around 40 amps.
+
+#define BLACK    0x0000
+#define BLUE     0x001F
+#define RED      0xF800
+#define GREEN    0x07E0
+#define YELLOW   0xFFE0
+
+// Static display panel interface
+HHLedPanel<HHLedPanel_16x64x16_impl<Platform, 5>> *panel = new HHLedPanel<HHLedPanel_16x64x16_impl<Platform, 5>>(MAX_BRIGHTNESS);
+
+static const int REPEATS = 20;
+
+// Report a result as pixels/second
+void report(const char *name, uint32_t pixels, uint32_t elapsed_uS)
+{
+  Serial.printf("%-24s %8lu pixels in %8lu uS = %10lu pixels/s\n", name,
+    (unsigned long)pixels, (unsigned long)elapsed_uS,
+    (unsigned long)(elapsed_uS ? (uint64_t)pixels * 1000000 / elapsed_uS : 0));
+}
+
+// Reference: fill a rectangle one pixel at a time
+void pixelFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t colour)
+{
+  for(int16_t j = y; j < y + h; j++)
+    for(int16_t i = x; i < x + w; i++)
+      panel->drawPixel(i, j, colour);
+}
+
+void benchmarkFillScreen()
+{
+  uint32_t pixels = (uint32_t)panel->width() * panel->height() * REPEATS;
+  uint32_t start = micros();
+  for(int n = 0; n < REPEATS; n++)
+    pixelFill(0, 0, panel->width(), panel->height(), (n & 1) ? BLUE : RED);
+  report("fillScreen (drawPixel)", pixels, micros() - start);
+
+  start = micros();
+  for(int n = 0; n < REPEATS; n++)
+    panel->fillRect(0, 0, panel->width(), panel->height(), (n & 1) ? BLUE : RED);
+  report("fillScreen (fillRect)", pixels, micros() - start);
+
+  start = micros();
+  for(int n = 0; n < REPEATS; n++)
+    panel->fillScreen((n & 1) ? BLUE : RED);
+  report("fillScreen", pixels, micros() - start);
+}
+
+void benchmarkTextBands()
+{
+  // Typical dashboard use: clear a text line before redrawing it
+  uint32_t pixels = (uint32_t)panel->width() * 8 * 8 * REPEATS;
+  uint32_t start = micros();
+  for(int n = 0; n < REPEATS; n++)
+    for(int16_t y = 0; y < 64; y += 8)
+      pixelFill(0, y, panel->width(), 8, (n & 1) ? GREEN : BLACK);
+  report("text bands (drawPixel)", pixels, micros() - start);
+
+  start = micros();
+  for(int n = 0; n < REPEATS; n++)
+    for(int16_t y = 0; y < 64; y += 8)
+      panel->fillRect(0, y, panel->width(), 8, (n & 1) ? GREEN : BLACK);
+  report("text bands (fillRect)", pixels, micros() - start);
+}
+
+void benchmarkLines()
+{
+  uint32_t pixels = (uint32_t)panel->width() * panel->height() * REPEATS;
+  uint32_t start = micros();
+  for(int n = 0; n < REPEATS; n++)
+    for(int16_t y = 0; y < panel->height(); y++)
+      panel->drawFastHLine(0, y, panel->width(), (n & 1) ? YELLOW : BLUE);
+  report("drawFastHLine", pixels, micros() - start);
+
+  start = micros();
+  for(int n = 0; n < REPEATS; n++)
+    for(int16_t x = 0; x < panel->width(); x++)
+      panel->drawFastVLine(x, 0, panel->height(), (n & 1) ? YELLOW : BLUE);
+  report("drawFastVLine", pixels, micros() - start);
+}
+
+void benchmarkWritePixels()
+{
+  // As used for each line of an AnimatedGIF frame
+  static uint16_t line[240];
+  for(int i = 0; i < 240; i++)
+    line[i] = i * 273;
+
+  uint32_t pixels = (uint32_t)panel->width() * panel->height() * REPEATS;
+  uint32_t start = micros();
+  for(int n = 0; n < REPEATS; n++)
+  {
+    for(int16_t y = 0; y < panel->height(); y++)
+    {
+      panel->startWrite();
+      panel->setAddrWindow(0, y, panel->width(), 1);
+      panel->writePixels(line, panel->width(), false, false);
+      panel->endWrite();
+    }
+  }
+  report("writePixels lines", pixels, micros() - start);
+}
+
+void benchmarkEncodeRow()
+{
+  // Whole panel rows (rotation 0) through drawPixel and through the bulk row encoder
+  static uint16_t line[64];
+  for(int i = 0; i < 64; i++)
+    line[i] = i * 1057;
+
+  panel->setRotation(0);
+  uint32_t pixels = (uint32_t)panel->width() * panel->height() * REPEATS;
+  uint32_t start = micros();
+  for(int n = 0; n < REPEATS; n++)
+    for(int16_t y = 0; y < panel->height(); y++)
+      for(int16_t x = 0; x < panel->width(); x++)
+        panel->drawPixel(x, y, line[x]);
+  report("rows (drawPixel)", pixels, micros() - start);
+
+  start = micros();
+  for(int n = 0; n < REPEATS; n++)
+  {
+    for(int16_t y = 0; y < panel->height(); y++)
+    {
+      panel->setAddrWindow(0, y, panel->width(), 1);
+      panel->writePixels(line, panel->width(), false, false);
+    }
+  }
+  report("rows (encodeRow)", pixels, micros() - start);
+  panel->setRotation(1);
+}
+
+void benchmarkRotations()
+{
+  // drawPixel for each rotation, restoring the wall's rotation afterwards
+  static const char *names[] = { "drawPixel rotation 0", "drawPixel rotation 1", "drawPixel rotation 2", "drawPixel rotation 3" };
+  for(uint8_t rotation = 0; rotation < 4; rotation++)
+  {
+    panel->setRotation(rotation);
+    uint32_t pixels = (uint32_t)panel->width() * panel->height() * REPEATS;
+    uint32_t start = micros();
+    for(int n = 0; n < REPEATS; n++)
+      pixelFill(0, 0, panel->width(), panel->height(), (n & 1) ? GREEN : RED);
+    report(names[rotation], pixels, micros() - start);
+  }
+  panel->setRotation(1);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  delay(1000);
+
+  // Start the display
+  panel->begin();
+  panel->setRotation(1);
+}
+
+void loop()
+{
+  Serial.printf("\nHH LED panel benchmark, %d x %d pixels\n", panel->width(), panel->height());
+  benchmarkFillScreen();
+  benchmarkTextBands();
+  benchmarkLines();
+  benchmarkWritePixels();
+  benchmarkEncodeRow();
+  benchmarkRotations();
+  delay(5000);
+}
@@ -26,7 +26,7 @@ const uint8_t PROGMEM gamma8[] = {
   215,218,220,223,225,228,231,233,236,239,241,244,247,249,252,255 };
 
 // 6-bit version
-const uint8_t PROGMEM gamma6[] = {
+constexpr uint8_t PROGMEM gamma6[] = {
     0,  0,  0,  0,
     0,  0,  0,  1,
     1,  1,  2,  2,
@@ -42,4 +42,33 @@ const uint8_t PROGMEM gamma6[] = {
   120,127,135,142,
   150,158,167,175,
   184,193,203,213,
-  223,233,244,255 };
\ No newline at end of file
+  223,233,244,255 };
+
+//////////////////////////////////////////////////////////////////////////
+// Compile-time tables mapping a colour component straight to the bits it
+// sets in each colour depth bit plane, i.e. bit n of an entry is set if the
+// gamma-corrected value has its nth most significant bit set.
+//
+// GammaPlanes<COLOUR_DEPTH, 32, 1>::value is indexed by a 5-bit red or blue
+// component and GammaPlanes<COLOUR_DEPTH, 64, 0>::value by a 6-bit green one.
+//
+constexpr uint8_t gamma_planes(uint8_t value, uint8_t depths)
+{
+  return depths == 0 ? 0 :
+    gamma_planes(value, depths - 1) | (((value >> (8 - depths)) & 1) << (depths - 1));
+}
+
+template<unsigned short COLOUR_DEPTH, uint16_t N, uint8_t SHIFT, uint8_t... Rest>
+struct GammaPlanes
+{
+  static constexpr auto& value = GammaPlanes<COLOUR_DEPTH, N-1, SHIFT, gamma_planes(gamma6[(N-1) << SHIFT], COLOUR_DEPTH), Rest...>::value;
+};
+
+template<unsigned short COLOUR_DEPTH, uint8_t SHIFT, uint8_t... Rest>
+struct GammaPlanes <COLOUR_DEPTH, 0, SHIFT, Rest...>
+{
+  static constexpr uint8_t value[] = {Rest...};
+};
+
+template<unsigned short COLOUR_DEPTH, uint8_t SHIFT, uint8_t... Rest>
+constexpr uint8_t GammaPlanes<COLOUR_DEPTH, 0, SHIFT, Rest...>::value[];